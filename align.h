@@ -0,0 +1,29 @@
+// ============================================
+// Alignment helpers shared by the allocators.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#ifndef ALIGN_H
+#define ALIGN_H
+
+/**
+ * The Pool and the Arena pad every object (and their slab or block headers)
+ * to a multiple of this type's size, so that objects stay suitably aligned
+ * for any member type.
+ */
+typedef union {
+    void *p;
+    double d;
+    long long l;
+} MaxAlign;
+
+/** n rounded up to a multiple of sizeof(MaxAlign) */
+#define ALIGN_ROUND(n) \
+    ((((n) + sizeof(MaxAlign) - 1) / sizeof(MaxAlign)) * sizeof(MaxAlign))
+
+#endif // ALIGN_H
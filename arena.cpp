@@ -0,0 +1,146 @@
+// ============================================
+// The Arena (bump allocator) class file
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#include "arena.h"
+#include "align.h"
+
+#include <stdlib.h> // For malloc and free
+#include <string.h> // For memset
+
+/**
+ * The header at the start of every block. The memory handed out follows it
+ * directly.
+ */
+typedef struct _ArenaBlock
+{
+    struct _ArenaBlock *next;
+
+    /** The number of bytes the block can hold after its header */
+    unsigned int size;
+} ArenaBlock;
+
+struct _Arena
+{
+    /** The size of a regular block */
+    unsigned int block_size;
+
+    /** All blocks allocated so far, oldest first */
+    ArenaBlock *first;
+    ArenaBlock *last;
+
+    /** The block being handed out, or NULL if every block is used up */
+    ArenaBlock *current;
+
+    /** The number of bytes of the current block already handed out */
+    unsigned int top;
+
+    /** Usage counters */
+    ArenaStats stats;
+};
+
+/**
+ * blockMemory
+ *
+ * Returns the first byte a block hands out.
+ *
+ * @param block The pointer to the block.
+ */
+static char *blockMemory(ArenaBlock *block)
+{
+    return (char *)block + ALIGN_ROUND(sizeof(ArenaBlock));
+}
+
+/**
+ * addBlock
+ *
+ * Allocates one block of at least size bytes, appends it to the arena and
+ * makes it the current block.
+ *
+ * @param arena The pointer to the arena.
+ * @param size The number of bytes the block must hold.
+ */
+static void addBlock(Arena *arena, unsigned int size)
+{
+    if (size < arena->block_size) size = arena->block_size;
+    ArenaBlock *block = (ArenaBlock *)malloc(ALIGN_ROUND(sizeof(ArenaBlock)) + size);
+    block->next = NULL;
+    block->size = size;
+    if (arena->last) arena->last->next = block;
+    else arena->first = block;
+    arena->last = block;
+    arena->current = block;
+    arena->top = 0;
+    arena->stats.capacity += size;
+    arena->stats.blocks++;
+}
+
+Arena *createArena(unsigned int blockSize)
+{
+    Arena *arena = (Arena *)malloc(sizeof(Arena));
+    arena->block_size = ALIGN_ROUND(blockSize ? blockSize : 1);
+    arena->first = NULL;
+    arena->last = NULL;
+    arena->current = NULL;
+    arena->top = 0;
+    arena->stats.used = 0;
+    arena->stats.peak = 0;
+    arena->stats.capacity = 0;
+    arena->stats.blocks = 0;
+    return arena;
+}
+
+void destroyArena(Arena *arena)
+{
+    ArenaBlock *block = arena->first;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+void *arenaAlloc(Arena *arena, unsigned int size)
+{
+    size = ALIGN_ROUND(size ? size : 1);
+    // move on to the next kept block while the current one is too full; the
+    // space left behind is only reclaimed by the next reset
+    while (arena->current && arena->top + size > arena->current->size) {
+        arena->current = arena->current->next;
+        arena->top = 0;
+    }
+    if (!arena->current) addBlock(arena, size);
+    void *memory = blockMemory(arena->current) + arena->top;
+    arena->top += size;
+    arena->stats.used += size;
+    if (arena->stats.used > arena->stats.peak) {
+        arena->stats.peak = arena->stats.used;
+    }
+    return memory;
+}
+
+void *arenaCalloc(Arena *arena, unsigned int n, unsigned int size)
+{
+    void *memory = arenaAlloc(arena, n * size);
+    memset(memory, 0, n * size);
+    return memory;
+}
+
+void arenaReset(Arena *arena)
+{
+    arena->current = arena->first;
+    arena->top = 0;
+    arena->stats.used = 0;
+}
+
+void getArenaStats(Arena *arena, ArenaStats *stats)
+{
+    *stats = arena->stats;
+}
@@ -0,0 +1,109 @@
+// ============================================
+// The header file for the Arena (bump allocator) class file.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#ifndef ARENA_H
+#define ARENA_H
+
+/**
+ * An Arena hands out memory of any size by bumping a pointer through large
+ * blocks. Objects are never freed one at a time: arenaReset releases
+ * everything allocated so far at once, in O(1), and keeps the blocks to be
+ * handed out again, so a structure that is torn down and rebuilt over and
+ * over (a map being regenerated, say) reuses the same memory without the
+ * heap ever seeing it.
+ *
+ * The definition of _Arena is implemented in arena.cpp.
+ */
+typedef struct _Arena Arena;
+
+/**
+ * Usage counters for an arena, filled in by getArenaStats.
+ */
+typedef struct {
+    /** The number of bytes handed out since the last reset */
+    unsigned int used;
+
+    /** The highest value used has reached */
+    unsigned int peak;
+
+    /** The number of bytes the allocated blocks can hold */
+    unsigned int capacity;
+
+    /** The number of blocks allocated from the heap */
+    unsigned int blocks;
+} ArenaStats;
+
+/**
+ * createArena
+ *
+ * Creates an empty arena. No block is allocated until the first arenaAlloc.
+ *
+ * @param blockSize The size in bytes of each block. A larger allocation gets
+ *                  a block of its own.
+ * @return a pointer to the new arena
+ */
+Arena* createArena(unsigned int blockSize);
+
+/**
+ * destroyArena
+ *
+ * Frees every block and the arena itself. Everything allocated from the
+ * arena becomes invalid.
+ *
+ * @param arena The pointer to the arena.
+ */
+void destroyArena(Arena* arena);
+
+/**
+ * arenaAlloc
+ *
+ * Allocates size bytes, suitably aligned for any type, adding a new block if
+ * the ones the arena has are full. The contents are uninitialized.
+ *
+ * @param arena The pointer to the arena.
+ * @param size The number of bytes to allocate.
+ * @return a pointer to the memory
+ */
+void* arenaAlloc(Arena* arena, unsigned int size);
+
+/**
+ * arenaCalloc
+ *
+ * Like arenaAlloc, for n objects of the given size, with the memory set to
+ * zero.
+ *
+ * @param arena The pointer to the arena.
+ * @param n The number of objects.
+ * @param size The size in bytes of each object.
+ * @return a pointer to the memory
+ */
+void* arenaCalloc(Arena* arena, unsigned int n, unsigned int size);
+
+/**
+ * arenaReset
+ *
+ * Frees everything allocated from the arena at once, without touching the
+ * objects. The blocks are kept and handed out again by later allocations.
+ *
+ * @param arena The pointer to the arena.
+ */
+void arenaReset(Arena* arena);
+
+/**
+ * getArenaStats
+ *
+ * Reads the usage counters of an arena.
+ *
+ * @param arena The pointer to the arena.
+ * @param stats The counters are written here.
+ */
+void getArenaStats(Arena* arena, ArenaStats* stats);
+
+#endif // ARENA_H
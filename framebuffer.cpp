@@ -0,0 +1,380 @@
+// ============================================
+// The off-screen framebuffer class file
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#include "framebuffer.h"
+#include "globals.h"
+#include "sprite_bake.h" // for rgb565
+
+#include <string.h> // For memset and memcpy
+
+/**
+ * The buffer takes 32KB, as much as the LPC1768's main RAM, so it is split
+ * into a top and a bottom half that live in the two 16KB AHB RAM banks the
+ * program doesn't otherwise use. Other targets keep both halves in regular
+ * memory.
+ */
+#define FB_HALF (FB_SIZE / 2)
+#ifdef TARGET_LPC1768
+#define FB_BANK(name) __attribute__((section(name), aligned(4)))
+#else
+#define FB_BANK(name)
+#endif
+
+static uint16_t fb_top[FB_HALF][FB_SIZE] FB_BANK("AHBSRAM0");
+static uint16_t fb_bottom[FB_HALF][FB_SIZE] FB_BANK("AHBSRAM1");
+
+/**
+ * The number of rectangles remembered between flushes. Drawing more than
+ * this flushes early.
+ */
+#define FB_MAX_DIRTY 64
+
+/**
+ * uLCD.BLIT takes one int per pixel, so large rectangles are sent in bands
+ * of at most this many pixels to bound the memory used for the colors.
+ */
+#define FB_BLIT_PIXELS 512
+
+/** The color of a dirty rectangle that isn't all one color */
+#define FB_MIXED -1
+
+/**
+ * A rectangle of the screen that was drawn since the last flush, corners
+ * included. A rectangle filled with one color is sent as a 12 byte
+ * uLCD.filled_rectangle instead of two bytes per pixel, so the color is
+ * kept.
+ */
+typedef struct {
+    int16_t x1, y1, x2, y2;
+    int color;
+} FbRect;
+
+static FbRect dirty[FB_MAX_DIRTY];
+static int num_dirty;
+
+/**
+ * returns row y of the buffer.
+ */
+static inline uint16_t* fb_row(int y)
+{
+    return (y < FB_HALF) ? fb_top[y] : fb_bottom[y - FB_HALF];
+}
+
+/**
+ * returns an RGB565 pixel as the 0xRRGGBB color the uLCD methods take. they
+ * send only the top 5/6/5 bits of each color, so the pixel is widened back
+ * into exactly the bits that are kept.
+ */
+static inline int widen(uint16_t p)
+{
+    return ((p >> 11) << 19) | (((p >> 5) & 0x3F) << 10) | ((p & 0x1F) << 3);
+}
+
+/**
+ * returns whether r covers all of d.
+ */
+static inline int contains(const FbRect* r, const FbRect* d)
+{
+    return r->x1 <= d->x1 && r->x2 >= d->x2 && r->y1 <= d->y1 && r->y2 >= d->y2;
+}
+
+/**
+ * returns whether a and b share at least one pixel.
+ */
+static inline int overlaps(const FbRect* a, const FbRect* b)
+{
+    return a->x1 <= b->x2 && b->x1 <= a->x2 && a->y1 <= b->y2 && b->y1 <= a->y2;
+}
+
+/**
+ * returns whether the union of a and b is itself a rectangle: one contains
+ * the other, or they share two edges and touch or overlap. merging only those
+ * never sends a pixel outside what was drawn, so text printed straight to the
+ * screen next to the drawing is left alone.
+ */
+static int lines_up(const FbRect* a, const FbRect* b)
+{
+    if (contains(a, b) || contains(b, a)) return true;
+    if (a->x1 == b->x1 && a->x2 == b->x2) return a->y1 <= b->y2 + 1 && b->y1 <= a->y2 + 1;
+    if (a->y1 == b->y1 && a->y2 == b->y2) return a->x1 <= b->x2 + 1 && b->x1 <= a->x2 + 1;
+    return false;
+}
+
+/**
+ * returns whether anything remembered after rectangle i was drawn over it.
+ */
+static int drawn_over(int i)
+{
+    for (int j = i + 1; j < num_dirty; j++) {
+        if (overlaps(&dirty[j], &dirty[i])) return true;
+    }
+    return false;
+}
+
+/**
+ * grows r to cover rectangle i as well, and removes rectangle i, keeping the
+ * others in order.
+ */
+static void absorb(FbRect* r, int i)
+{
+    FbRect* d = &dirty[i];
+    if (d->x1 < r->x1) r->x1 = d->x1;
+    if (d->y1 < r->y1) r->y1 = d->y1;
+    if (d->x2 > r->x2) r->x2 = d->x2;
+    if (d->y2 > r->y2) r->y2 = d->y2;
+    num_dirty--;
+    memmove(&dirty[i], &dirty[i + 1], (num_dirty - i) * sizeof(FbRect));
+}
+
+/**
+ * remembers that the rectangle with corners (x1,y1) and (x2,y2) is about to
+ * be drawn, all in one color or FB_MIXED. the corners must already be
+ * ordered and clipped.
+ *
+ * the rectangles are flushed in the order they were drawn, so a one color
+ * rectangle that something else was later drawn over is still filled first
+ * and the rest sent after it. a one color rectangle can only be merged into
+ * the one being drawn if nothing was drawn over it since, or the merged fill
+ * would cover up what was. mixed rectangles are merged by fb_flush instead,
+ * so that one which is later drawn over whole can still be dropped.
+ */
+static void mark_dirty(int x1, int y1, int x2, int y2, int color)
+{
+    FbRect r = {(int16_t)x1, (int16_t)y1, (int16_t)x2, (int16_t)y2, color};
+    // absorb every remembered rectangle that r covers or lines up with. the
+    // grown rectangle may now line up with ones checked before, so start over
+    int i = 0;
+    while (i < num_dirty) {
+        FbRect* d = &dirty[i];
+        if (contains(&r, d) || (color != FB_MIXED && d->color == color && lines_up(d, &r)
+                                && !drawn_over(i))) {
+            absorb(&r, i);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    if (num_dirty == FB_MAX_DIRTY) fb_flush();
+    dirty[num_dirty++] = r;
+}
+
+/**
+ * merges the mixed rectangles that line up. a BLIT sends what the buffer
+ * holds in the end, so the merged rectangle can take the later one's place.
+ */
+static void merge_mixed()
+{
+    int i = 0;
+    while (i < num_dirty) {
+        int j = num_dirty;
+        if (dirty[i].color == FB_MIXED) {
+            for (j = i + 1; j < num_dirty; j++) {
+                if (dirty[j].color == FB_MIXED && lines_up(&dirty[i], &dirty[j])) break;
+            }
+        }
+        if (j < num_dirty) {
+            absorb(&dirty[j], i);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+}
+
+/**
+ * sets one pixel if it is on the screen. the caller marks it dirty.
+ */
+static inline void plot(int x, int y, uint16_t p)
+{
+    if (x < 0 || y < 0 || x >= FB_SIZE || y >= FB_SIZE) return;
+    fb_row(y)[x] = p;
+}
+
+void fb_clear()
+{
+    memset(fb_top, 0, sizeof(fb_top));
+    memset(fb_bottom, 0, sizeof(fb_bottom));
+    num_dirty = 0;
+}
+
+void fb_filled_rectangle(int x1, int y1, int x2, int y2, int color)
+{
+    int t;
+    if (x1 > x2) { t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { t = y1; y1 = y2; y2 = t; }
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= FB_SIZE) x2 = FB_SIZE - 1;
+    if (y2 >= FB_SIZE) y2 = FB_SIZE - 1;
+    if (x1 > x2 || y1 > y2) return;
+
+    mark_dirty(x1, y1, x2, y2, color);
+    uint16_t p = rgb565(color);
+    for (int y = y1; y <= y2; y++) {
+        uint16_t* row = fb_row(y);
+        for (int x = x1; x <= x2; x++) row[x] = p;
+    }
+}
+
+void fb_rectangle(int x1, int y1, int x2, int y2, int color)
+{
+    fb_line(x1, y1, x2, y1, color);
+    fb_line(x1, y2, x2, y2, color);
+    fb_line(x1, y1, x1, y2, color);
+    fb_line(x2, y1, x2, y2, color);
+}
+
+void fb_line(int x1, int y1, int x2, int y2, int color)
+{
+    // straight lines are just thin rectangles
+    if (x1 == x2 || y1 == y2) {
+        fb_filled_rectangle(x1, y1, x2, y2, color);
+        return;
+    }
+    // a sloped line is sent as its whole bounding box, rather than as one
+    // rectangle per pixel
+    int bx1 = (x1 < x2) ? x1 : x2, bx2 = (x1 < x2) ? x2 : x1;
+    int by1 = (y1 < y2) ? y1 : y2, by2 = (y1 < y2) ? y2 : y1;
+    if (bx1 < 0) bx1 = 0;
+    if (by1 < 0) by1 = 0;
+    if (bx2 >= FB_SIZE) bx2 = FB_SIZE - 1;
+    if (by2 >= FB_SIZE) by2 = FB_SIZE - 1;
+    if (bx1 > bx2 || by1 > by2) return;
+    mark_dirty(bx1, by1, bx2, by2, FB_MIXED);
+
+    // Bresenham's algorithm
+    uint16_t p = rgb565(color);
+    int dx = (x2 > x1) ? x2 - x1 : x1 - x2;
+    int dy = (y2 > y1) ? y1 - y2 : y2 - y1;
+    int sx = (x2 > x1) ? 1 : -1;
+    int sy = (y2 > y1) ? 1 : -1;
+    int err = dx + dy;
+    while (1) {
+        plot(x1, y1, p);
+        if (x1 == x2 && y1 == y2) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x1 += sx; }
+        if (e2 <= dx) { err += dx; y1 += sy; }
+    }
+}
+
+void fb_triangle(int x1, int y1, int x2, int y2, int x3, int y3, int color)
+{
+    fb_line(x1, y1, x2, y2, color);
+    fb_line(x2, y2, x3, y3, color);
+    fb_line(x3, y3, x1, y1, color);
+}
+
+void fb_filled_circle(int x, int y, int r, int color)
+{
+    // one span per row, as wide as the circle is at that row
+    for (int dy = -r; dy <= r; dy++) {
+        int dx = 0;
+        while ((dx + 1) * (dx + 1) + dy * dy <= r * r + r) dx++;
+        fb_filled_rectangle(x - dx, y + dy, x + dx, y + dy, color);
+    }
+}
+
+void fb_blit(int x, int y, int w, int h, const uint16_t* pixels)
+{
+    int x1 = (x < 0) ? 0 : x;
+    int y1 = (y < 0) ? 0 : y;
+    int x2 = (x + w > FB_SIZE) ? FB_SIZE - 1 : x + w - 1;
+    int y2 = (y + h > FB_SIZE) ? FB_SIZE - 1 : y + h - 1;
+    if (x1 > x2 || y1 > y2) return;
+
+    mark_dirty(x1, y1, x2, y2, FB_MIXED);
+    for (int j = y1; j <= y2; j++) {
+        memcpy(fb_row(j) + x1, pixels + (j - y) * w + (x1 - x), (x2 - x1 + 1) * sizeof(uint16_t));
+    }
+}
+
+/**
+ * returns the color of the pixels in r, or FB_MIXED if they aren't all the
+ * same.
+ */
+static int solid_color(const FbRect* r)
+{
+    uint16_t p = fb_row(r->y1)[r->x1];
+    for (int y = r->y1; y <= r->y2; y++) {
+        const uint16_t* row = fb_row(y);
+        for (int x = r->x1; x <= r->x2; x++) {
+            if (row[x] != p) return FB_MIXED;
+        }
+    }
+    return widen(p);
+}
+
+void fb_scroll(int x, int y, int w, int h, int dx, int dy, int cell)
+{
+    fb_flush();
+    if (dx <= -w || dx >= w || dy <= -h || dy >= h) return;
+
+    // the part of the region that receives pixels from inside it
+    int x1 = (dx > 0) ? x + dx : x;
+    int y1 = (dy > 0) ? y + dy : y;
+    int cols = (w - ((dx > 0) ? dx : -dx)) / cell;
+    int rows = (h - ((dy > 0) ? dy : -dy)) / cell;
+
+    // moving down starts from the bottom, so that no row is overwritten
+    // before it has been moved
+    unsigned char changed[FB_SIZE];
+    for (int r = 0; r < rows; r++) {
+        int cy = (dy > 0) ? y1 + (rows - 1 - r) * cell : y1 + r * cell;
+        memset(changed, 0, cols);
+        for (int j = 0; j < cell; j++) {
+            int row = (dy > 0) ? cy + cell - 1 - j : cy + j;
+            uint16_t* dst = fb_row(row) + x1;
+            const uint16_t* src = fb_row(row - dy) + x1 - dx;
+            for (int c = 0; c < cols; c++) {
+                if (!changed[c] && memcmp(dst + c * cell, src + c * cell, cell * sizeof(uint16_t))) {
+                    changed[c] = true;
+                }
+            }
+            memmove(dst, src, cols * cell * sizeof(uint16_t));
+        }
+        for (int c = 0; c < cols; c++) {
+            if (!changed[c]) continue;
+            int cx = x1 + c * cell;
+            FbRect block = {(int16_t)cx, (int16_t)cy, (int16_t)(cx + cell - 1),
+                            (int16_t)(cy + cell - 1), FB_MIXED};
+            mark_dirty(block.x1, block.y1, block.x2, block.y2, solid_color(&block));
+        }
+    }
+}
+
+void fb_flush()
+{
+    static int colors[FB_BLIT_PIXELS];
+    merge_mixed();
+    for (int i = 0; i < num_dirty; i++) {
+        FbRect* r = &dirty[i];
+        // a mixed rectangle may have ended up all one color, such as a block
+        // that scrolled over a sprite but is blank itself
+        int color = (r->color != FB_MIXED) ? r->color : solid_color(r);
+        if (color != FB_MIXED) {
+            uLCD.filled_rectangle(r->x1, r->y1, r->x2, r->y2, color);
+            continue;
+        }
+        int w = r->x2 - r->x1 + 1;
+        int rows = FB_BLIT_PIXELS / w;
+        for (int y = r->y1; y <= r->y2; y += rows) {
+            int h = (r->y2 - y + 1 < rows) ? r->y2 - y + 1 : rows;
+            int* c = colors;
+            for (int j = 0; j < h; j++) {
+                const uint16_t* row = fb_row(y + j) + r->x1;
+                for (int k = 0; k < w; k++) *c++ = widen(row[k]);
+            }
+            uLCD.BLIT(r->x1, y, w, h, colors);
+            wait_us(250); // Recovery time!
+        }
+    }
+    num_dirty = 0;
+}
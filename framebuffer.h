@@ -0,0 +1,112 @@
+// ============================================
+// The header file for the off-screen framebuffer.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stdint.h>
+
+/**
+ * The framebuffer is a copy of the 128x128 screen in RGB565, kept in memory.
+ * The fb_ drawing functions below work like the uLCD methods of the same
+ * name, but only change the copy and remember which rectangles they touched.
+ * fb_flush then sends those rectangles to the screen, merged into as few
+ * commands as it can: a region filled with one color goes as a single
+ * uLCD.filled_rectangle, anything else as a uLCD.BLIT of its pixels. A frame
+ * costs one serial command per changed region instead of one (plus a
+ * recovery wait after every sprite) per shape.
+ *
+ * Text is not drawn into the framebuffer; uLCD.printf writes straight to the
+ * screen. Call fb_flush before printing over something drawn with the fb_
+ * functions, so the text lands on top of it.
+ *
+ * Colors are 0xRRGGBB, as for the uLCD methods. Coordinates outside the
+ * screen are clipped.
+ */
+
+/** The width and height of the screen, in pixels */
+#define FB_SIZE 128
+
+/**
+ * fb_clear
+ *
+ * Fills the framebuffer with black and forgets any unflushed drawing, to
+ * match the screen after uLCD.cls(). Call it once before drawing anything,
+ * and again after each uLCD.cls().
+ */
+void fb_clear();
+
+/**
+ * fb_filled_rectangle
+ *
+ * Fills the rectangle with corners (x1,y1) and (x2,y2), both included.
+ */
+void fb_filled_rectangle(int x1, int y1, int x2, int y2, int color);
+
+/**
+ * fb_rectangle
+ *
+ * Draws the one pixel outline of the rectangle with corners (x1,y1) and
+ * (x2,y2).
+ */
+void fb_rectangle(int x1, int y1, int x2, int y2, int color);
+
+/**
+ * fb_line
+ *
+ * Draws the line from (x1,y1) to (x2,y2), both ends included. A sloped line
+ * is flushed as its whole bounding box.
+ */
+void fb_line(int x1, int y1, int x2, int y2, int color);
+
+/**
+ * fb_triangle
+ *
+ * Draws the outline of the triangle with the given corners.
+ */
+void fb_triangle(int x1, int y1, int x2, int y2, int x3, int y3, int color);
+
+/**
+ * fb_filled_circle
+ *
+ * Fills the circle of radius r centered on (x,y).
+ */
+void fb_filled_circle(int x, int y, int r, int color);
+
+/**
+ * fb_blit
+ *
+ * Copies a w x h block of RGB565 pixels, in row-major order, with its top
+ * left corner at (x,y).
+ */
+void fb_blit(int x, int y, int w, int h, const uint16_t* pixels);
+
+/**
+ * fb_scroll
+ *
+ * Moves what is drawn in the w x h region with its top left corner at (x,y)
+ * by (dx,dy) pixels, as when the view follows the player. The region is a
+ * grid of cell x cell blocks, and dx and dy are whole cells; only the blocks
+ * whose pixels change are sent by the next flush. The band the picture moves
+ * away from keeps its old pixels, for the caller to draw over.
+ *
+ * Whatever was drawn before is flushed first, so the blocks are compared
+ * against what the screen shows.
+ */
+void fb_scroll(int x, int y, int w, int h, int dx, int dy, int cell);
+
+/**
+ * fb_flush
+ *
+ * Sends everything drawn since the last flush to the screen.
+ */
+void fb_flush();
+
+#endif // FRAMEBUFFER_H
@@ -10,58 +10,78 @@
 
 #include "graphics.h"
 #include "globals.h"
+#include "framebuffer.h"
+#include "sprite_bake.h"
 
 
 
 ///////////////////////////////////////////
-// Drawing Images Based on Characters
+// Drawing Sprites
 ///////////////////////////////////////////
 
-// additional color definitions
-#define YELLOW 0xFFFF00
-#define BROWN  0xD2691E
-#define DIRT   BROWN
-#define PURPLE 0xA020F0
-#define DGREEN 0x009E60
-#define LGREEN 0xAFE1AF
-// You can define more hex colors here
+/**
+ * The palette as RGB565 pixels, and every pair of 4 bit indices (one byte of
+ * a 4 bit sprite) as the two pixels it stands for, packed in one word the
+ * way they are laid out in memory: the first pixel in the low half on the
+ * little-endian LPC1768. Both tables are built at compile time and kept in
+ * flash.
+ */
+struct PaletteTable {
+    uint16_t colors[SPRITE_PALETTE_SIZE];
+};
+struct PairTable {
+    uint32_t pairs[256];
+};
+
+template <unsigned... I>
+static constexpr PaletteTable make_palette(Indices<I...>)
+{
+    return PaletteTable{{rgb565(SPRITE_PALETTE[I])...}};
+}
+
+template <unsigned... I>
+static constexpr PairTable make_pairs(Indices<I...>)
+{
+    return PairTable{{(rgb565(SPRITE_PALETTE[I & 15])
+                       | ((uint32_t)rgb565(SPRITE_PALETTE[I >> 4]) << 16))...}};
+}
+
+static constexpr PaletteTable PALETTE = make_palette(MakeIndices<SPRITE_PALETTE_SIZE>::type());
+static constexpr PairTable PAIRS = make_pairs(MakeIndices<256>::type());
 
 /**
- * function to draw images based on characters
- * takes in an image array and changes color
- * labeled by a character to a hex value (ex: 'Y' -> 0xFFF00)
+ * function to draw a 4 bit sprite baked by bake_sprite (see sprite_bake.h)
+ * into the framebuffer. each byte of the sprite is two pixels, which a
+ * single lookup turns into one word of RGB565.
 **/
-void draw_img(int u, int v, const char* img)
+void draw_img(int u, int v, const Sprite<4>& sprite)
 {
-    int colors[11*11];
-    for (int i = 0; i < 11*11; i++)
-    {
-        // you can add more characters by defining their hex values above
-        if (img[i] == 'R') colors[i] = RED;
-        else if (img[i] == 'Y') colors[i] = YELLOW;
-        else if (img[i] == 'G') colors[i] = GREEN;
-        else if (img[i] == 'D') colors[i] = DIRT;
-        else if (img[i] == '5') colors[i] = LGREY;
-        else if (img[i] == '3') colors[i] = DGREY;
-        else if (img[i] == 'B') colors[i] = BLUE;
-        else if (img[i] == 'P') colors[i] = PURPLE;
-        else if (img[i] == '4') colors[i] = DGREEN;
-        else if (img[i] == 'L') colors[i] = LGREEN;
-        else if (img[i] == 'W') colors[i] = WHITE;
-        else colors[i] = BLACK;
-    }
-    uLCD.BLIT(u, v, 11, 11, colors);
-    wait_us(250); // Recovery time!
+    union {
+        uint32_t pairs[sizeof(sprite.data)];
+        uint16_t pixels[2 * sizeof(sprite.data)];
+    } expanded;
+    for (unsigned i = 0; i < sizeof(sprite.data); i++) expanded.pairs[i] = PAIRS.pairs[sprite.data[i]];
+    fb_blit(u, v, SPRITE_SIZE, SPRITE_SIZE, expanded.pixels);
+}
+
+/**
+ * function to draw an 8 bit sprite into the framebuffer.
+**/
+void draw_img(int u, int v, const Sprite<8>& sprite)
+{
+    uint16_t pixels[SPRITE_PIXELS];
+    for (int i = 0; i < SPRITE_PIXELS; i++) pixels[i] = PALETTE.colors[sprite.data[i]];
+    fb_blit(u, v, SPRITE_SIZE, SPRITE_SIZE, pixels);
 }
 
 
 ///////////////////////////////////////////////////
-// Simple Drawing of Objects Using uLCD Methods
+// Simple Drawing of Objects Using Framebuffer Methods
 ///////////////////////////////////////////////////
 
 void draw_nothing(int u, int v)
 {
-    uLCD.filled_rectangle(u, v, u+10, v+10, BLACK);
+    fb_filled_rectangle(u, v, u+10, v+10, BLACK);
 }
 
 void draw_player(int u, int v, int key, bool gift)
@@ -69,58 +89,58 @@ void draw_player(int u, int v, int key, bool gift)
     if (key) // player has the key!
     {
         // body
-        uLCD.filled_circle(u, v, 2, GREEN);
+        fb_filled_circle(u, v, 2, GREEN);
         // head
-        uLCD.filled_rectangle(u-2, v+2, u+2, v+4, GREEN);
+        fb_filled_rectangle(u-2, v+2, u+2, v+4, GREEN);
         // hat
-        if (!gift) uLCD.triangle(u-3, v-2, u, v-6, u+3, v-2, YELLOW);
+        if (!gift) fb_triangle(u-3, v-2, u, v-6, u+3, v-2, YELLOW);
         if (gift) {
-            uLCD.filled_rectangle(u-2, v-2, u+2, v-10, WHITE); // top of hat
-            uLCD.filled_rectangle(u-4, v-1, u+4, v-2, WHITE); // bottom of hat
+            fb_filled_rectangle(u-2, v-2, u+2, v-10, WHITE); // top of hat
+            fb_filled_rectangle(u-4, v-1, u+4, v-2, WHITE); // bottom of hat
         }
         // arms & legs
-        uLCD.line(u-2, v+3, u-4, v+3, GREEN);
-        uLCD.line(u+2, v+3, u+4, v+3, GREEN);
-        uLCD.line(u-1, v+4, u-1, v+7, GREEN);
-        uLCD.line(u+1, v+4, u+1, v+7, GREEN);
+        fb_line(u-2, v+3, u-4, v+3, GREEN);
+        fb_line(u+2, v+3, u+4, v+3, GREEN);
+        fb_line(u-1, v+4, u-1, v+7, GREEN);
+        fb_line(u+1, v+4, u+1, v+7, GREEN);
     }
     else
     {
         // body
-        uLCD.filled_circle(u, v, 2, BLUE);
+        fb_filled_circle(u, v, 2, BLUE);
         // head
-        uLCD.filled_rectangle(u-2, v+2, u+2, v+4, BLUE);
+        fb_filled_rectangle(u-2, v+2, u+2, v+4, BLUE);
         // hat
-        if (!gift) uLCD.triangle(u-3, v-2, u, v-6, u+3, v-2, YELLOW);
+        if (!gift) fb_triangle(u-3, v-2, u, v-6, u+3, v-2, YELLOW);
         if (gift) {
-            uLCD.filled_rectangle(u-2, v-2, u+2, v-10, WHITE); // top of hat
-            uLCD.filled_rectangle(u-4, v-1, u+4, v-2, WHITE); // bottom of hat
+            fb_filled_rectangle(u-2, v-2, u+2, v-10, WHITE); // top of hat
+            fb_filled_rectangle(u-4, v-1, u+4, v-2, WHITE); // bottom of hat
         }
         // arms & legs
-        uLCD.line(u-2, v+3, u-4, v+3, BLUE);
-        uLCD.line(u+2, v+3, u+4, v+3, BLUE);
-        uLCD.line(u-1, v+4, u-1, v+7, BLUE);
-        uLCD.line(u+1, v+4, u+1, v+7, BLUE);
+        fb_line(u-2, v+3, u-4, v+3, BLUE);
+        fb_line(u+2, v+3, u+4, v+3, BLUE);
+        fb_line(u-1, v+4, u-1, v+7, BLUE);
+        fb_line(u+1, v+4, u+1, v+7, BLUE);
     }
 }
 
 
 void draw_wall(int u, int v)
 {
-    uLCD.filled_rectangle(u, v, u+10, v+10, 0x808080); // grey walls
+    fb_filled_rectangle(u, v, u+10, v+10, 0x808080); // grey walls
 }
 
 void draw_door(int u, int v)
 {
     draw_nothing(u,v);
-    uLCD.line(u, v+6, u+11, v+6, 0xFFFF00);
+    fb_line(u, v+6, u+11, v+6, 0xFFFF00);
 }
 
 void draw_new_door(int u, int v)
 {
     draw_nothing(u,v);
-    uLCD.line(u, v+6, u+5, v+6, GREEN);
-    uLCD.line(u+6, v+6, u+5, v+6, GREEN);
+    fb_line(u, v+6, u+5, v+6, GREEN);
+    fb_line(u+6, v+6, u+5, v+6, GREEN);
 }
 
 /**
@@ -132,7 +152,8 @@ void draw_upper_status(int x, int y, bool k)
     uLCD.text_height(1);
     uLCD.text_width(1);
     uLCD.set_font(FONT_7X8);
-    uLCD.filled_rectangle(0, 0, 127, 17, 0xf6f6f6);
+    fb_filled_rectangle(0, 0, 127, 17, 0xf6f6f6);
+    fb_flush(); // the text goes on top of everything drawn so far
     uLCD.textbackground_color(0xf6f6f6);
     uLCD.color(0);
     uLCD.printf(" Player:(%i,%i)\n Has Key: %s   \n", x, y, k ? "true" : "false");
@@ -146,10 +167,11 @@ void draw_lower_status(int h)
     uLCD.locate(0,14);
     uLCD.text_height(1);
     uLCD.text_width(1);
-    uLCD.filled_rectangle(0, 110, 127, 120, 0xf6f6f6);
+    fb_filled_rectangle(0, 110, 127, 120, 0xf6f6f6);
     uLCD.textbackground_color(0xf6f6f6);
-    uLCD.filled_rectangle(60, 112, 70+h, 117, 0x4CBB17);
-    uLCD.rectangle(59, 112, 120, 117, BLACK);
+    fb_filled_rectangle(60, 112, 70+h, 117, 0x4CBB17);
+    fb_rectangle(59, 112, 120, 117, BLACK);
+    fb_flush(); // the text goes on top of everything drawn so far
     uLCD.color(0);
     uLCD.printf(" Health:");
 }
@@ -159,10 +181,10 @@ void draw_lower_status(int h)
  */
 void draw_border()
 {
-    uLCD.filled_rectangle(0,     0, 127,  3,  0xf6f6f6); // top
-    uLCD.filled_rectangle(0,    13,   2, 114, 0xf6f6f6); // left
-    uLCD.filled_rectangle(0,   114, 127, 117, 0xf6f6f6); // bottom
-    uLCD.filled_rectangle(124,  14, 127, 117, 0xf6f6f6); // right
+    fb_filled_rectangle(0,     0, 127,  3,  0xf6f6f6); // top
+    fb_filled_rectangle(0,    13,   2, 114, 0xf6f6f6); // left
+    fb_filled_rectangle(0,   114, 127, 117, 0xf6f6f6); // bottom
+    fb_filled_rectangle(124,  14, 127, 117, 0xf6f6f6); // right
 }
 
 /**
@@ -236,7 +258,7 @@ void draw_start_up() {
 
 void draw_plant(int u, int v)
 {
-    const char* img = 
+    static constexpr char img[] =
         "           "
         " GGGGGGGG  "
         " GGGGGGGGG "
@@ -248,13 +270,14 @@ void draw_plant(int u, int v)
         "    DD     "
         "   DDDDD   "
         "  D  D  D  ";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 
 void draw_npc(int u, int v)
 {
-    const char* img = 
+    static constexpr char img[] =
         "     R     "
         "    RRR    "
         "   RRRRR   "
@@ -266,12 +289,13 @@ void draw_npc(int u, int v)
         "   RRRRR   "
         "    RRR    "
         "     R     ";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 void draw_stairs(int u, int v)
 {
-    const char* img =
+    static constexpr char img[] =
         "        333"
         "        353"
         "      33333"
@@ -283,7 +307,8 @@ void draw_stairs(int u, int v)
         "33333333333"
         "35555555553"
         "33333333333";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 
@@ -295,7 +320,7 @@ void draw_stairs(int u, int v)
 void draw_buzz(int u, int v)
 {
 
-int new_piskel_data[121] = {
+static constexpr uint32_t new_piskel_data[SPRITE_PIXELS] = {
 0x00000000, 0x00000000, 0x00000000, 0xff58110c, 0xff58110c, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
 0x00000000, 0x00000000, 0xff58110c, 0x00000000, 0x00000000, 0xff58110c, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
 0x00000000, 0x00000000, 0x00000000, 0xffffff00, 0xffffffff, 0xff0000ff, 0xff606060, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
@@ -309,13 +334,14 @@ int new_piskel_data[121] = {
 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xff58110c, 0xffffff00, 0xffffff00, 0x00000000, 0x00000000, 0x00000000, 0x00000000
 };
 
-   uLCD.BLIT(u,v, 11,11, new_piskel_data);
+static constexpr Sprite<8> sprite = bake_sprite<8>(new_piskel_data);
+   draw_img(u, v, sprite);
 }
 
 void draw_slain_buzz(int u, int v)
 {
 
-int new_piskel_data[121] = {
+static constexpr uint32_t new_piskel_data[SPRITE_PIXELS] = {
 0x00000000, 0x00000000, 0x00000000, 0xffcccb,   0xffcccb,   0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
 0x00000000, 0x00000000, 0xffcccb,   0x00000000, 0x00000000, 0xffcccb,   0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
 0x00000000, 0x00000000, 0x00000000, 0xffcccb,   0xffcccb,   0xffcccb,   0xffcccb,   0x00000000, 0x00000000, 0x00000000, 0x00000000, 
@@ -329,7 +355,8 @@ int new_piskel_data[121] = {
 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffcccb,   0xffcccb,   0xffcccb,   0x00000000, 0x00000000, 0x00000000, 0x00000000
 };
 
-   uLCD.BLIT(u,v, 11,11, new_piskel_data);
+static constexpr Sprite<4> sprite = bake_sprite<4>(new_piskel_data);
+   draw_img(u, v, sprite);
 }
 
 
@@ -337,7 +364,7 @@ void draw_water(int u, int v)
 {
 
 
-int new_piskel_data[121] = {
+static constexpr uint32_t new_piskel_data[SPRITE_PIXELS] = {
 
 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xff0101c4, 0xff0101c4, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xff0101c4, 0xff0101c4, 0xff0101c4, 0xff0101c4, 0x00000000, 0x00000000, 0x00000000, 
@@ -352,13 +379,14 @@ int new_piskel_data[121] = {
 0x00000000, 0x00000000, 0x00000000, 0xff0101c4, 0xff0101c4, 0xff0101c4, 0xff0101c4, 0xff0101c4, 0x00000000, 0x00000000, 0x00000000
 
 };
-   uLCD.BLIT(u,v, 11,11, new_piskel_data);
+static constexpr Sprite<4> sprite = bake_sprite<4>(new_piskel_data);
+   draw_img(u, v, sprite);
 }
 
 void draw_fire(int u, int v)
 {
 
-int new_piskel_data[121] = {
+static constexpr uint32_t new_piskel_data[SPRITE_PIXELS] = {
 
 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
 0xffff0009, 0xffff0009, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
@@ -373,13 +401,14 @@ int new_piskel_data[121] = {
 0xffff0009, 0xffff0009, 0xffff0009, 0xffb30007, 0xffb30007, 0xffb30007, 0xffb30007, 0xffb30007, 0xffff0009, 0xffff0009, 0xffff0009
 
 };
-   uLCD.BLIT(u,v, 11,11, new_piskel_data);
+static constexpr Sprite<8> sprite = bake_sprite<8>(new_piskel_data);
+   draw_img(u, v, sprite);
 }
 
 void draw_earth(int u, int v)
 {
 
-int new_piskel_data[121] = {
+static constexpr uint32_t new_piskel_data[SPRITE_PIXELS] = {
 
 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 
@@ -394,7 +423,8 @@ int new_piskel_data[121] = {
 0xff00659e, 0xff00659e, 0xff00659e, 0xff00659e, 0xffffffff, 0xff00659e, 0xffffffff, 0xffffffff, 0xff00659e, 0xff00659e, 0xff00659e
 
 };
-   uLCD.BLIT(u,v, 11,11, new_piskel_data);
+static constexpr Sprite<4> sprite = bake_sprite<4>(new_piskel_data);
+   draw_img(u, v, sprite);
 }
 
 
@@ -407,7 +437,7 @@ int new_piskel_data[121] = {
 
 void draw_cave1(int u, int v)
 {
-    const char* img =
+    static constexpr char img[] =
         "33333333333"
         "33333333333"
         "33333333333"
@@ -419,11 +449,12 @@ void draw_cave1(int u, int v)
         "33333333333"
         "33333333333"
         "33333333333";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 void draw_cave2(int u, int v)
 {
-    const char* img =
+    static constexpr char img[] =
         "33333333333"
         "33333333333"
         "33333333333"
@@ -435,11 +466,12 @@ void draw_cave2(int u, int v)
         "33333333333"
         "33333333333"
         "33333333333";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 void draw_cave3(int u, int v)
 {
-    const char* img =
+    static constexpr char img[] =
         "33333333333"
         "33333333333"
         "33333333333"
@@ -451,11 +483,12 @@ void draw_cave3(int u, int v)
         "33333333000"
         "33333333000"
         "33333333000";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 void draw_cave4(int u, int v)
 {
-    const char* img =
+    static constexpr char img[] =
         "33333333333"
         "33333333333"
         "33333333333"
@@ -467,13 +500,14 @@ void draw_cave4(int u, int v)
         "33333333333"
         "33333333333"
         "33333333333";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 
 void draw_mud(int u, int v)
 {
-   const char* img = 
+   static constexpr char img[] =
         "DDDDDDDDDDD"
         "DDD3333DD3D"
         "D33D33D33DD"
@@ -485,11 +519,12 @@ void draw_mud(int u, int v)
         "D3D333D33DD"
         "DDDDD33DDDD"
         "DDDDDDDDDDD";
-    draw_img(u, v, img);
+   static constexpr Sprite<4> sprite = bake_sprite(img);
+   draw_img(u, v, sprite);
 }
 
 void draw_wreck(int u, int v) {
-    const char* img = 
+    static constexpr char img[] =
         "00YYYYYYY00"
         "500YY0YY005"
         "Y500Y0Y005Y"
@@ -506,12 +541,13 @@ void draw_wreck(int u, int v) {
         "05335353350"
         "03300000330"
         "03300000330";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 void draw_pebble(int u, int v) 
 {
-    const char* img = 
+    static constexpr char img[] =
         "     5     "
         "     5     "
         "   53335   "
@@ -523,12 +559,13 @@ void draw_pebble(int u, int v)
         "53533353355"
         "55555335555"
         "55555555555";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 void draw_power_up(int u, int v)
 {
-    const char* img = 
+    static constexpr char img[] =
         "GGGBBBBBGGG"
         " GGGBBBGGG "
         "  GGGBGGG  "
@@ -540,12 +577,13 @@ void draw_power_up(int u, int v)
         "           "
         "           "
         "           ";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 void draw_gift_box(int u, int v)
 {
-    const char* img = 
+    static constexpr char img[] =
         "P         P"
         "PP       PP"
         "PPP     PPP"
@@ -557,12 +595,13 @@ void draw_gift_box(int u, int v)
         "5YYPPYPPYY5"
         "5YYYPPPPYY5"
         "55555555555";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 void draw_bush(int u, int v)
 {
-    const char* img = 
+    static constexpr char img[] =
         " 44P44R44  "
         " 44R44R44  "
         " P444P4444 "
@@ -574,12 +613,13 @@ void draw_bush(int u, int v)
         "     D     "
         "     D     "
         "           ";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 void draw_hole(int u, int v)
 {
-    const char* img = 
+    static constexpr char img[] =
         "    555    "
         "  55DDD55  "
         " 55DDDDD55 "
@@ -591,12 +631,13 @@ void draw_hole(int u, int v)
         "           "
         "           "
         "           ";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 void draw_secret_entrance(int u, int v)
 {
-    const char* img = 
+    static constexpr char img[] =
         "44444444444"
         "4LLLLLLLLL4"
         "4LDDDDDDDL4"
@@ -608,12 +649,13 @@ void draw_secret_entrance(int u, int v)
         "4LDDDDDDDL4"
         "4LLLLLLLLL4"
         "44444444444";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 void draw_secret_stairs(int u, int v)
 {
-    const char* img =
+    static constexpr char img[] =
         "        444"
         "        4G4"
         "      44444"
@@ -625,12 +667,13 @@ void draw_secret_stairs(int u, int v)
         "44444444444"
         "4GGGGGGGGG4"
         "GGGGGGGGGGG";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
 
 void draw_mushroom(int u, int v)
 {
-    const char* img = 
+    static constexpr char img[] =
         "           "
         " RWWRRWWR  "
         " RWWRRWWRR "
@@ -642,5 +685,6 @@ void draw_mushroom(int u, int v)
         "    WW     "
         "   WWWW    "
         "           ";
-    draw_img(u, v, img);
+    static constexpr Sprite<4> sprite = bake_sprite(img);
+    draw_img(u, v, sprite);
 }
@@ -11,20 +11,24 @@
 #ifndef GRAPHICS_H
 #define GRAPHICS_H
 
+#include <stdint.h>
+
+/**
+ * The draw functions below draw into the framebuffer (see framebuffer.h),
+ * which draw_game sends to the screen at the end of each frame. Only the
+ * status bars print their text straight to the screen.
+ */
+
 /**
- * Takes a string image and draws it to the screen. The string is 121 characters
- * long, and represents an 11x11 tile in row-major ordering (across, then down,
- * like a regular multi-dimensional array). The available colors are:
- *      R = Red
- *      Y = Yellow
- *      G = Green
- *      D = Brown ("dirt")
- *      5 = Light grey (50%)
- *      3 = Dark grey (30%)
- *      Any other character is black
- * More colors can be easily added by following the pattern already given.
+ * Draws an 11x11 sprite with its top left corner at (u,v). Sprites are baked
+ * from a picture string or a Piskel color array at compile time by
+ * bake_sprite (see sprite_bake.h for the picture characters and the shared
+ * palette), and store a 4 or 8 bit palette index per pixel, which drawing
+ * looks up.
  */
-void draw_img(int u, int v, const char* img);
+template <int BITS> struct Sprite;
+void draw_img(int u, int v, const Sprite<4>& sprite);
+void draw_img(int u, int v, const Sprite<8>& sprite);
 
 /**
  * Draws the player. This depends on the player state, so it is not a DrawFunc.
@@ -0,0 +1,60 @@
+// ============================================
+// The hash function library.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#include "hash_functions.h"
+
+/**
+ * 2^32 divided by the golden ratio, rounded to an odd number.
+ */
+#define FIBONACCI_MULTIPLIER 2654435769u
+
+/**
+ * spreadBits
+ *
+ * Helper function that moves bit i of the low 16 bits of v to bit 2i.
+ *
+ * @param v The value whose low 16 bits are spread.
+ * @return the spread bits, with every odd bit zero
+ */
+static unsigned int spreadBits(unsigned int v)
+{
+    v &= 0xffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+unsigned int hash_identity(unsigned int key)
+{
+    return key;
+}
+
+unsigned int hash_fibonacci(unsigned int key)
+{
+    unsigned int h = key * FIBONACCI_MULTIPLIER;
+    return h ^ (h >> 16);
+}
+
+unsigned int hash_xorshift(unsigned int key)
+{
+    key ^= key >> 16;
+    key *= 0x7feb352du;
+    key ^= key >> 15;
+    key *= 0x846ca68bu;
+    key ^= key >> 16;
+    return key;
+}
+
+unsigned int hash_morton(unsigned int key)
+{
+    return spreadBits(key) | (spreadBits(key >> 16) << 1);
+}
@@ -0,0 +1,58 @@
+// ============================================
+// The header file for the hash function library.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#ifndef HASH_FUNCTIONS_H
+#define HASH_FUNCTIONS_H
+
+/**
+ * A small family of HashFunction implementations (see hash_table.h) for
+ * integer keys. The table reduces the hash to a bucket with a modulo
+ * (HT_CHAINED) or a power-of-two mask (HT_ROBIN_HOOD), so a good hash here
+ * has well mixed low bits. tools/hash_bench.cpp compares them on the game's
+ * map layouts.
+ */
+
+/**
+ * hash_identity
+ *
+ * Returns the key unchanged, leaving all the work to the table's reduction.
+ * Cheapest, but keys that differ by a multiple of the bucket count collide,
+ * and runs of consecutive keys (a wall along a row) fill a run of slots.
+ */
+unsigned int hash_identity(unsigned int key);
+
+/**
+ * hash_fibonacci
+ *
+ * Multiplicative (Fibonacci) hashing: multiplies by 2^32 divided by the
+ * golden ratio and folds the well mixed high half onto the low half.
+ * One multiply, one shift and one xor.
+ */
+unsigned int hash_fibonacci(unsigned int key);
+
+/**
+ * hash_xorshift
+ *
+ * An xorshift-multiply finalizer: every input bit affects every output bit.
+ * The best spread of the family, for two multiplies and three shifts.
+ */
+unsigned int hash_xorshift(unsigned int key);
+
+/**
+ * hash_morton
+ *
+ * Interleaves the bits of the low and high 16 bits of the key, so for a key
+ * packed as (y << 16) | x nearby tiles get nearby hashes. It only makes
+ * sense for keys packed that way; for a key like x + y * width whose high
+ * half is zero it just spreads the bits apart.
+ */
+unsigned int hash_morton(unsigned int key);
+
+#endif // HASH_FUNCTIONS_H
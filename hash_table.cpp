@@ -26,6 +26,8 @@
  ***************************************************************************/
 #include <stdlib.h> // For malloc and free
 #include <stdio.h>  // For printf
+#include "pool.h"   // For the HashTableEntry slab pool
+#include "typed_hash_table.h" // For the HT_ROBIN_HOOD backend
 
 /****************************************************************************
  * Hidden Definitions
@@ -34,23 +36,127 @@
  * the are forward declared in hash_table.h, the type names are
  * available everywhere and user code can hold pointers to these structs.
  ***************************************************************************/
+/**
+ * Adapts the table's HashFunction pointer to the functor interface that
+ * TypedHashTable expects. The hash of a C table is only known at run time,
+ * so this is the one call per probe that cannot be inlined.
+ */
+struct HashFunctionCaller
+{
+    HashFunction hash;
+
+    HashFunctionCaller(HashFunction h = NULL) : hash(h) {}
+    unsigned int operator()(unsigned int key) const { return hash(key); }
+};
+
+/**
+ * The HT_ROBIN_HOOD backend is a TypedHashTable of void* values.
+ */
+typedef TypedHashTable<unsigned int, void *, HashFunctionCaller> RobinHoodTable;
+
 /**
  * This structure represents an a hash table.
  * Use "HashTable" instead when you are creating a new variable. [See top comments]
+ *
+ * When a chained table is resized, the new buckets become current and the
+ * previous ones are kept in the old_* members until every entry has been
+ * migrated. Migration happens a few buckets at a time during insertItem and
+ * removeItem. The Robin Hood backend does the same internally.
  */
 struct _HashTable
 {
+    /** The storage backend, HT_CHAINED or HT_ROBIN_HOOD */
+    int backend;
+
     /** The array of pointers to the head of a singly linked list, whose nodes
-        are HashTableEntry objects */
+        are HashTableEntry objects (HT_CHAINED only) */
     HashTableEntry **buckets;
 
+    /** The flat key/value table (HT_ROBIN_HOOD only) */
+    RobinHoodTable *rh;
+
+    /** The slab pool every HashTableEntry is allocated from (HT_CHAINED only) */
+    Pool *entry_pool;
+
     /** The hash function pointer */
     HashFunction hash;
 
-    /** The number of buckets in the hash table */
+    /** The function that frees stored values, or NULL if the table does not
+        own its values */
+    ValueFreeFunction free_value;
+
+    /** The number of buckets in the hash table (HT_CHAINED only) */
     unsigned int num_buckets;
+
+    /** The number of items currently stored in the hash table */
+    unsigned int size;
+
+    /** The bucket count the table was created with; it never shrinks below */
+    unsigned int min_buckets;
+
+    /** The buckets being migrated away from, or NULL when no resize is in
+        progress */
+    HashTableEntry **old_buckets;
+    unsigned int old_num_buckets;
+
+    /** The next old bucket to migrate */
+    unsigned int migrate_pos;
+
+    /** The lookup counters (HT_CHAINED only; kept when HT_STATS is defined) */
+    HashTableStats stats;
 };
 
+/**
+ * The load factor limits of a chained table, in percent. It grows once it
+ * holds more than HT_MAX_LOAD items per hundred buckets, and shrinks (never
+ * below its initial size) once it drops under HT_MIN_LOAD. The Robin Hood
+ * backend uses its own limits (see typed_hash_table.h).
+ */
+#define HT_MAX_LOAD 100
+#define HT_MIN_LOAD 20
+
+/**
+ * The number of non-empty old buckets migrated per
+ * insertItem/removeItem call while a resize is in progress. At most
+ * HT_MIGRATE_SCAN empty buckets are skipped per call on top of that.
+ */
+#define HT_MIGRATE_STEP 4
+#define HT_MIGRATE_SCAN (4 * HT_MIGRATE_STEP)
+
+/**
+ * The number of HashTableEntry objects carved from each slab of the entry pool.
+ */
+#define HT_ENTRIES_PER_SLAB 32
+
+/**
+ * getItems resolves keys in groups of HT_BATCH, advancing every lookup of a
+ * group by one probe step per round so that their memory accesses overlap.
+ */
+#define HT_BATCH 8
+
+/**
+ * Adds n to one lookup counter of a chained table. Compiles away unless
+ * HT_STATS is defined; stats is still evaluated, so the helpers that take
+ * it as a parameter don't warn about it going unused.
+ */
+#ifdef HT_STATS
+#define HT_COUNT(stats, field, n) ((stats)->field += (n))
+#else
+#define HT_COUNT(stats, field, n) ((void)(stats))
+#endif
+
+/**
+ * The number of histogram bins printed by printHashTableStats.
+ */
+#define HT_PRINT_BINS 8
+
+/**
+ * The state of each lookup in a getItems group.
+ */
+#define PROBE_PENDING 0
+#define PROBE_FOUND   1
+#define PROBE_MISSED  2
+
 /**
  * This structure represents a hash table entry.
  * Use "HashTableEntry" instead when you are creating a new variable. [See top comments]
@@ -79,18 +185,20 @@ struct _HashTableEntry
 /**
  * createHashTableEntry
  *
- * Helper function that creates a hash table entry by allocating memory for it on
- * the heap. It initializes the entry with key and value, initialize pointer to
- * the next entry as NULL, and return the pointer to this hash table entry.
+ * Helper function that creates a hash table entry by allocating memory for it
+ * from the table's entry pool. It initializes the entry with key and value,
+ * initialize pointer to the next entry as NULL, and return the pointer to this
+ * hash table entry.
  *
+ * @param pool The entry pool of the hash table
  * @param key The key corresponds to the hash table entry
  * @param value The value stored in the hash table entry
  * @return The pointer to the hash table entry
  */
-static HashTableEntry *createHashTableEntry(unsigned int key, void *value)
+static HashTableEntry *createHashTableEntry(Pool *pool, unsigned int key, void *value)
 {
-    // allocate memory for hash table entry on the heap
-    HashTableEntry *newEntry = (HashTableEntry*)malloc(sizeof(HashTableEntry));
+    // allocate memory for hash table entry from the slab pool
+    HashTableEntry *newEntry = (HashTableEntry*)poolAlloc(pool);
 
     // initialize components of hash table entry
     newEntry->key = key;
@@ -102,21 +210,26 @@ static HashTableEntry *createHashTableEntry(unsigned int key, void *value)
 }
 
 /**
- * findItem
+ * findInBuckets
  *
- * Helper function that checks whether there exists the hash table entry that
- * contains a specific key.
+ * Helper function that searches one array of chained buckets for a key.
  *
- * @param hashTable The pointer to the hash table.
+ * @param buckets The array of bucket heads.
+ * @param numBuckets The number of buckets in the array.
+ * @param hash The hash function.
  * @param key The key corresponds to the hash table entry
+ * @param stats The counters to add the probes to.
  * @return The pointer to the hash table entry, or NULL if key does not exist
  */
-static HashTableEntry *findItem(HashTable *hashTable, unsigned int key)
+static HashTableEntry *findInBuckets(HashTableEntry **buckets, unsigned int numBuckets,
+                                     HashFunction hash, unsigned int key,
+                                     HashTableStats *stats)
 {
     // pointer to the item we want to find
-    HashTableEntry *item = hashTable->buckets[hashTable->hash(key)];
+    HashTableEntry *item = buckets[hash(key) % numBuckets];
     // loop to check if the key exists
     while(item) {
+        HT_COUNT(stats, probes, 1);
         if (item->key == key) {
             return item; // return pointer to the hash table entry
         }
@@ -125,6 +238,267 @@ static HashTableEntry *findItem(HashTable *hashTable, unsigned int key)
     return NULL; // key does not exist
 }
 
+/**
+ * findItem
+ *
+ * Helper function that checks whether there exists the hash table entry that
+ * contains a specific key. While a resize is in progress, both the current
+ * and the old buckets are searched. This counts as one lookup.
+ *
+ * @param hashTable The pointer to the hash table.
+ * @param key The key corresponds to the hash table entry
+ * @return The pointer to the hash table entry, or NULL if key does not exist
+ */
+static HashTableEntry *findItem(HashTable *hashTable, unsigned int key)
+{
+    HashTableEntry *item = findInBuckets(hashTable->buckets, hashTable->num_buckets,
+                                         hashTable->hash, key, &hashTable->stats);
+    if (!item && hashTable->old_buckets) {
+        item = findInBuckets(hashTable->old_buckets, hashTable->old_num_buckets,
+                             hashTable->hash, key, &hashTable->stats);
+    }
+    HT_COUNT(&hashTable->stats, lookups, 1);
+    if (item) HT_COUNT(&hashTable->stats, hits, 1);
+    else HT_COUNT(&hashTable->stats, misses, 1);
+    return item;
+}
+
+/**
+ * unlinkFromBuckets
+ *
+ * Helper function that removes the entry holding a key from one array of
+ * chained buckets, frees the entry and returns its value.
+ *
+ * @param pool The entry pool of the hash table.
+ * @param buckets The array of bucket heads.
+ * @param numBuckets The number of buckets in the array.
+ * @param hash The hash function.
+ * @param key The key that corresponds to the item.
+ * @param found Set to 1 if the key was present, 0 otherwise.
+ * @param stats The counters to add the probes to.
+ * @return the value of the removed entry, or NULL if the key is not present
+ */
+static void *unlinkFromBuckets(Pool *pool, HashTableEntry **buckets, unsigned int numBuckets,
+                               HashFunction hash, unsigned int key, int *found,
+                               HashTableStats *stats)
+{
+    // Get the bucket number and the head entry
+    unsigned int bucket_num = hash(key) % numBuckets;
+    HashTableEntry *head = buckets[bucket_num]; // head of the bucket
+    HashTableEntry *temp = head; // temporary variable
+    void *tempValue;
+
+    *found = 0;
+    // if the bucket is empty
+    if (!head) return NULL;
+    // If the head holds the key, change the head to the next value, and return the old value
+    tempValue = head->value;
+    HT_COUNT(stats, probes, 1);
+    if (head->key == key) {
+        temp = head->next;
+        poolFree(pool, head);
+        buckets[bucket_num] = temp; // head is now temp
+        *found = 1;
+        return tempValue;
+    }
+    // If not the head, search for the key to be removed
+    temp = head;
+    while(temp->next) {
+        HT_COUNT(stats, probes, 1);
+        if (temp->next->key == key) {
+            // unlink the node from the list and return the old value
+            tempValue = temp->next->value;
+            HashTableEntry *item = temp->next; // another temp
+            temp->next = temp->next->next;
+            poolFree(pool, item);
+            *found = 1;
+            return tempValue;
+        }
+        temp = temp->next;
+    }
+    // If the key is not present in the list, return NULL
+    return NULL;
+}
+
+/**
+ * freeBuckets
+ *
+ * Helper function that frees every stored value in one array of chained
+ * buckets, and then the array itself. The entries are not freed one by one:
+ * they are released in bulk with the entry pool.
+ *
+ * @param buckets The array of bucket heads.
+ * @param numBuckets The number of buckets in the array.
+ * @param freeValue The function that frees values, or NULL.
+ */
+static void freeBuckets(HashTableEntry **buckets, unsigned int numBuckets,
+                        ValueFreeFunction freeValue)
+{
+    for (unsigned int i = 0; freeValue && i < numBuckets; ++i) {
+        // free the values of all entries in the ith bucket
+        for (HashTableEntry *temp = buckets[i]; temp; temp = temp->next) {
+            freeValue(temp->value);
+        }
+    } // end loop
+    free(buckets);
+}
+
+/**
+ * chainedGetBatch
+ *
+ * Helper function that looks up a group of at most HT_BATCH keys in one array
+ * of chained buckets. The bucket heads are all fetched first, then every
+ * pending lookup advances by one node per round.
+ *
+ * @param buckets The array of bucket heads.
+ * @param numBuckets The number of buckets in the array.
+ * @param hash The hash function.
+ * @param keys The keys to look up.
+ * @param values The value of each key found is written here.
+ * @param state The outcome of each lookup (PROBE_FOUND or PROBE_MISSED).
+ * @param n The number of keys in the group.
+ * @param stats The counters to add the probes to.
+ */
+static void chainedGetBatch(HashTableEntry **buckets, unsigned int numBuckets, HashFunction hash,
+                            const unsigned int *keys, void **values, unsigned char *state,
+                            unsigned int n, HashTableStats *stats)
+{
+    unsigned int bucket[HT_BATCH];
+    HashTableEntry *item[HT_BATCH];
+    unsigned int pending = n;
+
+    // hash every key up front and start fetching its bucket head
+    for (unsigned int i = 0; i < n; ++i) {
+        bucket[i] = hash(keys[i]) % numBuckets;
+        THT_PREFETCH(&buckets[bucket[i]]);
+    }
+    // load the heads and start fetching the first node of every chain
+    for (unsigned int i = 0; i < n; ++i) {
+        item[i] = buckets[bucket[i]];
+        state[i] = PROBE_PENDING;
+        THT_PREFETCH(item[i]);
+    }
+
+    // one node per pending key per round
+    while (pending) {
+        for (unsigned int i = 0; i < n; ++i) {
+            if (state[i] != PROBE_PENDING) continue;
+            if (!item[i]) {
+                state[i] = PROBE_MISSED;
+                pending--;
+                continue;
+            }
+            HT_COUNT(stats, probes, 1);
+            if (item[i]->key == keys[i]) {
+                values[i] = item[i]->value;
+                state[i] = PROBE_FOUND;
+                pending--;
+            } else {
+                item[i] = item[i]->next;
+                THT_PREFETCH(item[i]);
+            }
+        }
+    }
+}
+
+/**
+ * isResizing
+ *
+ * Helper function that checks whether a resize is still migrating entries.
+ *
+ * @param hashTable The pointer to the hash table.
+ * @return nonzero while old storage still holds entries
+ */
+static int isResizing(HashTable *hashTable)
+{
+    return hashTable->old_buckets != NULL;
+}
+
+/**
+ * migrateStep
+ *
+ * Helper function that moves a bounded number of entries from the old
+ * storage into the current storage, and frees the old storage once it is
+ * empty. Chained entries are relinked, so no allocation happens here.
+ *
+ * @param hashTable The pointer to the hash table.
+ * @param budget The number of non-empty old buckets to migrate.
+ */
+static void migrateStep(HashTable *hashTable, unsigned int budget)
+{
+    unsigned int scanned = 0;
+    while (budget && hashTable->migrate_pos < hashTable->old_num_buckets
+           && scanned < HT_MIGRATE_SCAN) {
+        HashTableEntry *item = hashTable->old_buckets[hashTable->migrate_pos];
+        // empty buckets are cheap to skip, so they only count against the scan
+        if (item) budget--;
+        else scanned++;
+        // relink each entry of this old bucket onto its new bucket
+        while (item) {
+            HashTableEntry *next = item->next;
+            unsigned int bucket_num = hashTable->hash(item->key) % hashTable->num_buckets;
+            item->next = hashTable->buckets[bucket_num];
+            hashTable->buckets[bucket_num] = item;
+            item = next;
+        }
+        hashTable->old_buckets[hashTable->migrate_pos] = NULL;
+        hashTable->migrate_pos++;
+    }
+    if (hashTable->migrate_pos >= hashTable->old_num_buckets) {
+        free(hashTable->old_buckets);
+        hashTable->old_buckets = NULL;
+        hashTable->old_num_buckets = 0;
+    }
+}
+
+/**
+ * startResize
+ *
+ * Helper function that allocates new, empty storage of the given size and
+ * keeps the current storage as the old storage to migrate from. Any resize
+ * still in progress is finished first.
+ *
+ * @param hashTable The pointer to the hash table.
+ * @param numBuckets The number of buckets of the new storage.
+ */
+static void startResize(HashTable *hashTable, unsigned int numBuckets)
+{
+    while (isResizing(hashTable)) {
+        migrateStep(hashTable, hashTable->num_buckets);
+    }
+    hashTable->migrate_pos = 0;
+    hashTable->old_buckets = hashTable->buckets;
+    hashTable->old_num_buckets = hashTable->num_buckets;
+    hashTable->buckets = (HashTableEntry **)calloc(numBuckets, sizeof(HashTableEntry *));
+    hashTable->num_buckets = numBuckets;
+}
+
+/**
+ * maintain
+ *
+ * Helper function called by every insertItem and removeItem on a chained
+ * table. It advances a
+ * resize in progress, and starts a new one when the load factor has left the
+ * allowed range.
+ *
+ * @param hashTable The pointer to the hash table.
+ */
+static void maintain(HashTable *hashTable)
+{
+    if (isResizing(hashTable)) {
+        migrateStep(hashTable, HT_MIGRATE_STEP);
+    }
+    unsigned int n = hashTable->num_buckets;
+    if ((hashTable->size + 1) * 100 > n * HT_MAX_LOAD) {
+        // keep the bucket count odd so that modulo hashing stays well spread
+        startResize(hashTable, n * 2 + 1);
+    } else if (n > hashTable->min_buckets && hashTable->size * 100 < n * HT_MIN_LOAD
+               && !isResizing(hashTable)) {
+        unsigned int half = (n - 1) / 2;
+        startResize(hashTable, half > hashTable->min_buckets ? half : hashTable->min_buckets);
+    }
+}
+
 /****************************************************************************
  * Public Interface Functions
  *
@@ -133,7 +507,7 @@ static HashTableEntry *findItem(HashTable *hashTable, unsigned int key)
  * above sections.
  ****************************************************************************/
 // The createHashTable is provided for you as a starting point.
-HashTable *createHashTable(HashFunction hashFunction, unsigned int numBuckets)
+HashTable *createHashTable(HashFunction hashFunction, unsigned int numBuckets, int backend)
 {
     // The hash table has to contain at least one bucket. Exit gracefully if
     // this condition is not met.
@@ -147,9 +521,29 @@ HashTable *createHashTable(HashFunction hashFunction, unsigned int numBuckets)
     HashTable *newTable = (HashTable *)malloc(sizeof(HashTable));
 
     // Initialize the components of the new HashTable struct.
+    newTable->backend = backend;
     newTable->hash = hashFunction;
+    newTable->free_value = free;
+    newTable->entry_pool = NULL;
     newTable->num_buckets = numBuckets;
+    newTable->min_buckets = numBuckets;
+    newTable->size = 0;
+    newTable->buckets = NULL;
+    newTable->rh = NULL;
+    newTable->old_buckets = NULL;
+    newTable->old_num_buckets = 0;
+    newTable->migrate_pos = 0;
+    resetHashTableStats(newTable);
+
+    // The Robin Hood backend keeps everything in flat arrays instead.
+    if (backend == HT_ROBIN_HOOD)
+    {
+        newTable->rh = new RobinHoodTable(numBuckets, HashFunctionCaller(hashFunction));
+        return newTable;
+    }
+
     newTable->buckets = (HashTableEntry **)malloc(numBuckets * sizeof(HashTableEntry *));
+    newTable->entry_pool = createPool(sizeof(HashTableEntry), HT_ENTRIES_PER_SLAB);
 
     // As the new buckets are empty, init each bucket as NULL.
     unsigned int i;
@@ -164,49 +558,68 @@ HashTable *createHashTable(HashFunction hashFunction, unsigned int numBuckets)
 
 void destroyHashTable(HashTable *hashTable)
 {
-    // Loop through each bucket of the hash table to remove all items.
-    unsigned int numBuckets = hashTable->num_buckets;
-    for (unsigned int i = 0; i < numBuckets; ++i) {
-        // temp variable to hold the first entry of the ith bucket
-        HashTableEntry *temp = hashTable->buckets[i];
-        // delete all entries
-        while (temp) {
-            HashTableEntry *next = temp->next;
-            free(temp->value);
-            free(temp);
-            temp = next;
-
+    // Robin Hood: free every stored value, then the flat arrays.
+    if (hashTable->backend == HT_ROBIN_HOOD) {
+        RobinHoodTable::Cursor cursor;
+        void *value;
+        hashTable->rh->begin(cursor);
+        while (hashTable->free_value && hashTable->rh->next(cursor, NULL, &value)) {
+            hashTable->free_value(value);
         }
-    } // end loop
-    // Free buckets
-    free(hashTable->buckets);
+        delete hashTable->rh;
+        free(hashTable);
+        return;
+    }
+
+    // Free every value of the current and (if resizing) old buckets
+    freeBuckets(hashTable->buckets, hashTable->num_buckets, hashTable->free_value);
+    if (hashTable->old_buckets) {
+        freeBuckets(hashTable->old_buckets, hashTable->old_num_buckets, hashTable->free_value);
+    }
+    // Release every entry at once with the slab pool
+    destroyPool(hashTable->entry_pool);
     // Free hash table
     free(hashTable);
 }
 
 void *insertItem(HashTable *hashTable, unsigned int key, void *value)
 {
-    // First, we want to check if the key is present in the hash table.
-    HashTableEntry *oldItem = hashTable->buckets[hashTable->hash(key)];
     void *oldValue;
+
+    // Robin Hood: overwrite in place, or place the new key in current storage.
+    if (hashTable->backend == HT_ROBIN_HOOD) {
+        return hashTable->rh->insert(key, value, &oldValue) ? oldValue : NULL;
+    }
+
+    // First, we want to check if the key is present anywhere in its bucket.
+    HashTableEntry *oldItem = findItem(hashTable, key);
     // If the key is present in the hash table, store new value and return old value
-    if (oldItem != NULL && oldItem->key == key) {
+    if (oldItem != NULL) {
         oldValue = oldItem->value;
         oldItem->value = value;
         return oldValue;
     }
     // If not, create entry for new value and return NULL
-    HashTableEntry *newItem = createHashTableEntry(key, value);
-    HashTableEntry *head = hashTable->buckets[hashTable->hash(key)];
+    maintain(hashTable);
+    unsigned int bucket_num = hashTable->hash(key) % hashTable->num_buckets;
+    HashTableEntry *newItem = createHashTableEntry(hashTable->entry_pool, key, value);
+    HashTableEntry *head = hashTable->buckets[bucket_num];
     if (head) {
         newItem->next = head;
     }
-    hashTable->buckets[hashTable->hash(key)] = newItem;
+    hashTable->buckets[bucket_num] = newItem;
+    hashTable->size++;
     return NULL;
 }
 
 void *getItem(HashTable *hashTable, unsigned int key)
 {
+    // Robin Hood: a single probe over the contiguous slots (two mid-resize).
+    if (hashTable->backend == HT_ROBIN_HOOD) {
+        void **value = hashTable->rh->get(key);
+        return value ? *value : NULL;
+    }
+
     // First, we want to check if the key is present in the hash table.
     // If the key exists, return the value.
     // call findItem method
@@ -216,39 +629,78 @@ void *getItem(HashTable *hashTable, unsigned int key)
     return NULL;
 }
 
+void getItems(HashTable *hashTable, const unsigned int *keys, void **values,
+              unsigned int numKeys)
+{
+    unsigned char state[HT_BATCH];
+    void **found[HT_BATCH];
+
+    for (unsigned int base = 0; base < numKeys; base += HT_BATCH) {
+        unsigned int n = numKeys - base;
+        if (n > HT_BATCH) n = HT_BATCH;
+        const unsigned int *k = keys + base;
+        void **v = values + base;
+
+        // Robin Hood: the table interleaves the probes (and checks its old
+        // slots mid-resize) itself.
+        if (hashTable->backend == HT_ROBIN_HOOD) {
+            hashTable->rh->getMany(k, found, n);
+            for (unsigned int i = 0; i < n; ++i) v[i] = found[i] ? *found[i] : NULL;
+            continue;
+        }
+
+        for (unsigned int i = 0; i < n; ++i) v[i] = NULL;
+        chainedGetBatch(hashTable->buckets, hashTable->num_buckets, hashTable->hash,
+                        k, v, state, n, &hashTable->stats);
+
+        // mid-resize, keys not found yet may still be in the old buckets
+        for (unsigned int i = 0; isResizing(hashTable) && i < n; ++i) {
+            if (state[i] == PROBE_FOUND) continue;
+            HashTableEntry *item = findInBuckets(hashTable->old_buckets,
+                                                 hashTable->old_num_buckets,
+                                                 hashTable->hash, k[i], &hashTable->stats);
+            if (item) {
+                v[i] = item->value;
+                state[i] = PROBE_FOUND;
+            }
+        }
+#ifdef HT_STATS
+        for (unsigned int i = 0; i < n; ++i) {
+            if (state[i] == PROBE_FOUND) HT_COUNT(&hashTable->stats, hits, 1);
+            else HT_COUNT(&hashTable->stats, misses, 1);
+        }
+        HT_COUNT(&hashTable->stats, lookups, n);
+#endif
+    }
+}
+
 void *removeItem(HashTable *hashTable, unsigned int key)
 {
-    // Get the bucket number and the head entry
-    unsigned int bucket_num = hashTable->hash(key);
-    HashTableEntry *head = hashTable->buckets[bucket_num]; // head of the bucket
-    HashTableEntry *temp = head; // temporary variable
-    void *tempValue;
+    void *value = NULL;
+    int found = 0;
 
-    // if hashTable is empty
-    if (!head) return NULL;
-    // If the head holds the key, change the head to the next value, and return the old value
-    tempValue = head->value;
-    if (head->key == key) {
-        temp = head->next;
-        free(head);
-        hashTable->buckets[bucket_num] = temp; // head is now temp
-        return tempValue;
+    // Robin Hood: backward-shift the following entries over the removed slot.
+    if (hashTable->backend == HT_ROBIN_HOOD) {
+        return hashTable->rh->remove(key, &value) ? value : NULL;
     }
-    // If not the head, search for the key to be removed
-    temp = head;
-    while(temp->next) {
-        if (temp->next->key == key) {
-            // unlink the node from the list and return the old value
-            tempValue = temp->next->value;
-            HashTableEntry *item = temp->next; // another temp
-            temp->next = temp->next->next;
-            free(item);
-            return tempValue;
-        }
-        temp = temp->next;
+
+    // Search the current buckets first, then the old ones mid-resize
+    value = unlinkFromBuckets(hashTable->entry_pool, hashTable->buckets,
+                              hashTable->num_buckets, hashTable->hash, key, &found,
+                              &hashTable->stats);
+    if (!found && hashTable->old_buckets) {
+        value = unlinkFromBuckets(hashTable->entry_pool, hashTable->old_buckets,
+                                  hashTable->old_num_buckets, hashTable->hash, key, &found,
+                                  &hashTable->stats);
     }
-    // If the key is not present in the list, return NULL
-    return NULL;
+    HT_COUNT(&hashTable->stats, lookups, 1);
+    if (found) HT_COUNT(&hashTable->stats, hits, 1);
+    else HT_COUNT(&hashTable->stats, misses, 1);
+    // If the key is not present in the table, return NULL
+    if (!found) return NULL;
+    hashTable->size--;
+    maintain(hashTable);
+    return value;
 }
 
 void deleteItem(HashTable *hashTable, unsigned int key)
@@ -257,8 +709,173 @@ void deleteItem(HashTable *hashTable, unsigned int key)
     // call removeItem
     void *data = removeItem(hashTable, key);
     // check if value returned from remove is not NULL
-    if (data) {
+    if (data && hashTable->free_value) {
         // free that value
-        free(data);
+        hashTable->free_value(data);
+    }
+}
+
+void setHashTableValueFree(HashTable *hashTable, ValueFreeFunction freeValue)
+{
+    hashTable->free_value = freeValue;
+}
+
+unsigned int getHashTableSize(HashTable *hashTable)
+{
+    if (hashTable->backend == HT_ROBIN_HOOD) return hashTable->rh->size();
+    return hashTable->size;
+}
+
+unsigned int getHashTableNumBuckets(HashTable *hashTable)
+{
+    if (hashTable->backend == HT_ROBIN_HOOD) return hashTable->rh->numSlots();
+    return hashTable->num_buckets;
+}
+
+float getHashTableLoadFactor(HashTable *hashTable)
+{
+    if (hashTable->backend == HT_ROBIN_HOOD) return hashTable->rh->loadFactor();
+    return (float)hashTable->size / (float)hashTable->num_buckets;
+}
+
+void initCursor(HashTable *hashTable, HashTableCursor *cursor)
+{
+    cursor->table = hashTable;
+    cursor->entry = NULL;
+    cursor->index = 0;
+    cursor->old = 0;
+}
+
+int nextItem(HashTableCursor *cursor, unsigned int *key, void **value)
+{
+    HashTable *hashTable = cursor->table;
+
+    // Robin Hood: the table keeps its own position in index/old
+    if (hashTable->backend == HT_ROBIN_HOOD) {
+        RobinHoodTable::Cursor c;
+        c.index = cursor->index;
+        c.old = cursor->old;
+        int more = hashTable->rh->next(c, key, value);
+        cursor->index = c.index;
+        cursor->old = c.old;
+        return more;
+    }
+
+    // the current buckets are visited first, then the old ones mid-resize
+    for (; cursor->old < 2; cursor->old++, cursor->index = 0, cursor->entry = NULL) {
+        HashTableEntry **buckets = cursor->old ? hashTable->old_buckets : hashTable->buckets;
+        unsigned int numBuckets = cursor->old ? hashTable->old_num_buckets
+                                              : hashTable->num_buckets;
+        // continue along the current chain, or move on to the next bucket
+        while (!cursor->entry && buckets && cursor->index < numBuckets) {
+            cursor->entry = buckets[cursor->index++];
+        }
+        if (cursor->entry) {
+            if (key) *key = cursor->entry->key;
+            if (value) *value = cursor->entry->value;
+            cursor->entry = cursor->entry->next;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void forEachItem(HashTable *hashTable, HashTableVisitor visit, void *context)
+{
+    HashTableCursor cursor;
+    unsigned int key;
+    void *value;
+    initCursor(hashTable, &cursor);
+    while (nextItem(&cursor, &key, &value)) {
+        visit(key, value, context);
+    }
+}
+
+void getHashTableStats(HashTable *hashTable, HashTableStats *stats)
+{
+    if (hashTable->backend == HT_ROBIN_HOOD) {
+        const RobinHoodTable::Stats &rs = hashTable->rh->stats();
+        stats->lookups = rs.lookups;
+        stats->hits = rs.hits;
+        stats->misses = rs.misses;
+        stats->probes = rs.probes;
+        return;
+    }
+    *stats = hashTable->stats;
+}
+
+void resetHashTableStats(HashTable *hashTable)
+{
+    if (hashTable->rh) hashTable->rh->resetStats();
+    hashTable->stats.lookups = 0;
+    hashTable->stats.hits = 0;
+    hashTable->stats.misses = 0;
+    hashTable->stats.probes = 0;
+}
+
+unsigned int getHashTableHistogram(HashTable *hashTable, unsigned int *histogram,
+                                   unsigned int numBins)
+{
+    if (hashTable->backend == HT_ROBIN_HOOD) {
+        return hashTable->rh->histogram(histogram, numBins);
+    }
+
+    unsigned int longest = 0;
+    for (unsigned int i = 0; i < numBins; ++i) histogram[i] = 0;
+    // measure every chain of the current and (if resizing) old buckets
+    for (int old = 0; old < 2; ++old) {
+        HashTableEntry **buckets = old ? hashTable->old_buckets : hashTable->buckets;
+        unsigned int numBuckets = old ? hashTable->old_num_buckets : hashTable->num_buckets;
+        for (unsigned int i = 0; buckets && i < numBuckets; ++i) {
+            unsigned int len = 0;
+            for (HashTableEntry *item = buckets[i]; item; item = item->next) len++;
+            if (len > longest) longest = len;
+            histogram[len < numBins ? len : numBins - 1]++;
+        }
+    }
+    return longest;
+}
+
+/**
+ * printToStdout
+ *
+ * The default line writer of printHashTableStats.
+ *
+ * @param line The line to print.
+ */
+static void printToStdout(const char *line)
+{
+    printf("%s\n", line);
+}
+
+void printHashTableStats(HashTable *hashTable, const char *name, HashTablePrinter print)
+{
+    char line[80];
+    unsigned int histogram[HT_PRINT_BINS];
+    HashTableStats stats;
+
+    if (!print) print = printToStdout;
+    getHashTableStats(hashTable, &stats);
+    unsigned int longest = getHashTableHistogram(hashTable, histogram, HT_PRINT_BINS);
+
+    snprintf(line, sizeof(line), "%s: %u items, %u %s, load %.2f",
+             name, getHashTableSize(hashTable), getHashTableNumBuckets(hashTable),
+             hashTable->backend == HT_ROBIN_HOOD ? "slots" : "buckets",
+             getHashTableLoadFactor(hashTable));
+    print(line);
+#ifdef HT_STATS
+    snprintf(line, sizeof(line), "  lookups %u (hits %u, misses %u), probes %u, %.2f per lookup",
+             stats.lookups, stats.hits, stats.misses, stats.probes,
+             stats.lookups ? (float)stats.probes / (float)stats.lookups : 0.0f);
+    print(line);
+#endif
+    // one line per histogram bin; the last bin includes everything longer
+    snprintf(line, sizeof(line), "  %s (longest %u):",
+             hashTable->backend == HT_ROBIN_HOOD ? "probe distance" : "chain length", longest);
+    print(line);
+    for (unsigned int i = 0; i < HT_PRINT_BINS; ++i) {
+        snprintf(line, sizeof(line), "    %u%s: %u", i, i + 1 == HT_PRINT_BINS ? "+" : "",
+                 histogram[i]);
+        print(line);
     }
-}
\ No newline at end of file
+}
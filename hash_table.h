@@ -39,6 +39,12 @@
   */
 typedef unsigned int (*HashFunction)(unsigned int key);
 
+/**
+ * This defines a type that is a pointer to a function which frees a value
+ * stored in the hash table. The name of the type is "ValueFreeFunction".
+ */
+typedef void (*ValueFreeFunction)(void* value);
+
 /**
  * This defines a type that is a _HashTable struct. The definition for
  * _HashTable is implemented in hash_table.c.
@@ -57,6 +63,29 @@ typedef struct _HashTable HashTable;
  */
 typedef struct _HashTableEntry HashTableEntry;
 
+/****************************************************************************
+ * Storage Backends
+ *
+ * The hash table can store its entries in one of two ways. The backend is
+ * chosen when the table is created and cannot be changed afterwards; every
+ * other function in this header behaves the same regardless of the backend.
+ ***************************************************************************/
+/**
+ * Each bucket is a singly linked list of separately allocated HashTableEntry
+ * nodes. This is the original implementation and the default.
+ */
+#define HT_CHAINED      0
+
+/**
+ * Keys and values live in flat, contiguous arrays. Collisions are resolved
+ * with Robin Hood linear probing and removals use backward-shift deletion,
+ * so no per-entry allocation happens and a lookup scans neighbouring slots
+ * instead of chasing pointers through the heap. The arrays grow
+ * automatically when they get too full. This backend is a TypedHashTable
+ * (see typed_hash_table.h) with the hash function called through a pointer.
+ */
+#define HT_ROBIN_HOOD   1
+
 /**
  * createHashTable
  *
@@ -65,11 +94,19 @@ typedef struct _HashTableEntry HashTableEntry;
  * pointers to HashTableEntry objects based on the number of buckets available.
  * Each bucket contains a singly linked list, whose nodes are HashTableEntry objects.
  *
+ * With the HT_ROBIN_HOOD backend, numBuckets is instead the initial number of
+ * slots in the flat key/value arrays, rounded up to a power of two.
+ *
+ * The value returned by the hash function is reduced modulo the number of
+ * buckets by the table, so the hash function may return any unsigned value.
+ *
  * @param myHashFunc The pointer to the custom hash function.
  * @param numBuckets The number of buckets available in the hash table.
+ * @param backend The storage backend, HT_CHAINED (default) or HT_ROBIN_HOOD.
  * @return a pointer to the new hash table
  */
-HashTable* createHashTable(HashFunction myHashFunc, unsigned int numBuckets);
+HashTable* createHashTable(HashFunction myHashFunc, unsigned int numBuckets,
+                           int backend = HT_CHAINED);
 
 /**
  * destroyHashTable
@@ -80,6 +117,10 @@ HashTable* createHashTable(HashFunction myHashFunc, unsigned int numBuckets);
  * on heap that is associated with heap, including the values that users store in
  * the hash table.
  *
+ * The nodes are allocated from a slab pool owned by the table, so they are
+ * released in bulk rather than one by one. Values are freed with the
+ * table's value free function (free unless changed by setHashTableValueFree).
+ *
  * @param myHashTable The pointer to the hash table.
  *
  */
@@ -109,6 +150,24 @@ void* insertItem(HashTable* myHashTable, unsigned int key, void* value);
  */
 void* getItem(HashTable* myHashTable, unsigned int key);
 
+/**
+ * getItems
+ *
+ * Get the values that correspond to several keys at once. This returns the
+ * same values as calling getItem for each key, but the lookups are processed
+ * a group at a time with their probes interleaved, so the memory accesses of
+ * different keys overlap instead of running back to back (host builds also
+ * issue software prefetches). Use it when a caller needs a whole working set,
+ * such as every tile around the player.
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @param keys The keys to look up.
+ * @param values Receives the value for each key, or NULL if it is not present.
+ * @param numKeys The number of keys (and values).
+ */
+void getItems(HashTable* myHashTable, const unsigned int* keys, void** values,
+              unsigned int numKeys);
+
 /**
  * removeItem
  *
@@ -134,4 +193,181 @@ void* removeItem(HashTable* myHashTable, unsigned int key);
  */
 void deleteItem(HashTable* myHashTable, unsigned int key);
 
+/**
+ * setHashTableValueFree
+ *
+ * Set the function deleteItem and destroyHashTable use to free stored values.
+ * Tables created by createHashTable use free. Use this when the values come
+ * from a custom allocator, or pass NULL if the table does not own its values.
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @param freeValue The function that frees a value, or NULL.
+ */
+void setHashTableValueFree(HashTable* myHashTable, ValueFreeFunction freeValue);
+
+/****************************************************************************
+ * Iteration
+ *
+ * Both forms visit every item exactly once, in bucket order, touching only
+ * live entries (plus the bucket array itself). The table must not be
+ * modified while an iteration is in progress.
+ ***************************************************************************/
+/**
+ * This defines a type that is a pointer to a function which is called once
+ * per item by forEachItem. The name of the type is "HashTableVisitor".
+ */
+typedef void (*HashTableVisitor)(unsigned int key, void* value, void* context);
+
+/**
+ * forEachItem
+ *
+ * Call visit(key, value, context) for every item in the hash table.
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @param visit The function to call for each item.
+ * @param context An arbitrary pointer passed through to visit.
+ */
+void forEachItem(HashTable* myHashTable, HashTableVisitor visit, void* context);
+
+/**
+ * The position of an iteration over a hash table. The members are private
+ * to hash_table.cpp; they are only exposed so a cursor can live on the stack.
+ */
+typedef struct {
+    HashTable* table;
+    HashTableEntry* entry;
+    unsigned int index;
+    int old;
+} HashTableCursor;
+
+/**
+ * initCursor
+ *
+ * Position a cursor before the first item of the hash table.
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @param cursor The cursor to initialize.
+ */
+void initCursor(HashTable* myHashTable, HashTableCursor* cursor);
+
+/**
+ * nextItem
+ *
+ * Advance the cursor to the next item of the hash table.
+ *
+ * @param cursor The cursor.
+ * @param key Receives the key of the item (may be NULL).
+ * @param value Receives the value of the item (may be NULL).
+ * @return 1 if an item was returned, 0 once every item has been visited
+ */
+int nextItem(HashTableCursor* cursor, unsigned int* key, void** value);
+
+/****************************************************************************
+ * Load Factor
+ *
+ * The table counts the items it holds. When the load factor (items per
+ * bucket) gets too high the table grows to roughly twice as many buckets,
+ * and when it gets very low the table shrinks again, but never below the
+ * number of buckets it was created with. A resize does not move every entry
+ * at once: each following insertItem/removeItem migrates a few buckets, so
+ * no single call stalls the game loop. getItem never migrates entries.
+ ***************************************************************************/
+/**
+ * getHashTableSize
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @return the number of items currently stored in the hash table
+ */
+unsigned int getHashTableSize(HashTable* myHashTable);
+
+/**
+ * getHashTableNumBuckets
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @return the current number of buckets (HT_CHAINED) or slots (HT_ROBIN_HOOD)
+ */
+unsigned int getHashTableNumBuckets(HashTable* myHashTable);
+
+/**
+ * getHashTableLoadFactor
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @return the number of items divided by the current number of buckets
+ */
+float getHashTableLoadFactor(HashTable* myHashTable);
+
+/****************************************************************************
+ * Instrumentation
+ *
+ * Build with HT_STATS defined (e.g. -DHT_STATS, for every file) to have each
+ * table count its key lookups. Without it the counters cost nothing and
+ * always read zero. The chain-length histogram does not depend on HT_STATS:
+ * it is computed from the table's contents when asked for.
+ ***************************************************************************/
+/**
+ * The lookup counters of one table. Every getItem, insertItem, removeItem
+ * and every key of a getItems call is one lookup. A probe is one stored key
+ * compared against the key being looked up.
+ */
+typedef struct
+{
+    unsigned int lookups;
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int probes;
+} HashTableStats;
+
+/**
+ * getHashTableStats
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @param stats Receives the counters accumulated since the table was created
+ *              or last reset.
+ */
+void getHashTableStats(HashTable* myHashTable, HashTableStats* stats);
+
+/**
+ * resetHashTableStats
+ *
+ * Sets every counter of the table back to zero.
+ *
+ * @param myHashTable The pointer to the hash table.
+ */
+void resetHashTableStats(HashTable* myHashTable);
+
+/**
+ * getHashTableHistogram
+ *
+ * Counts how long the table's collision chains are. For HT_CHAINED,
+ * histogram[i] is the number of buckets holding i entries. For HT_ROBIN_HOOD,
+ * histogram[i] is the number of entries stored i slots past their home slot.
+ * The last bin also counts everything longer.
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @param histogram Receives numBins counts.
+ * @param numBins The number of bins in histogram (at least 1).
+ * @return the longest chain (or probe distance) in the table
+ */
+unsigned int getHashTableHistogram(HashTable* myHashTable, unsigned int* histogram,
+                                   unsigned int numBins);
+
+/**
+ * A function pointer type that writes one line of text. The line does not
+ * end with a newline.
+ */
+typedef void (*HashTablePrinter)(const char* line);
+
+/**
+ * printHashTableStats
+ *
+ * Writes a short report of the table: its size and load factor, the lookup
+ * counters, and the chain-length histogram.
+ *
+ * @param myHashTable The pointer to the hash table.
+ * @param name The name to print at the top of the report.
+ * @param print The line writer, or NULL to printf to stdout.
+ */
+void printHashTableStats(HashTable* myHashTable, const char* name,
+                         HashTablePrinter print = 0);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+// ============================================
+// Host stand-in for the navigation switch library.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#ifndef NAV_SWITCH_H
+#define NAV_SWITCH_H
+
+#include "mbed.h"
+
+/** A navigation switch nobody touches */
+class Nav_Switch {
+public:
+    Nav_Switch(PinName /*up*/, PinName /*down*/, PinName /*left*/, PinName /*right*/,
+               PinName /*fire*/) {}
+    bool up() { return false; }
+    bool down() { return false; }
+    bool left() { return false; }
+    bool right() { return false; }
+    bool center() { return false; }
+    int read() { return 0; }
+    operator int() { return read(); }
+};
+
+#endif // NAV_SWITCH_H
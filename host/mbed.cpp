@@ -0,0 +1,13 @@
+// ============================================
+// Host stand-ins for the parts of the mbed library the game uses.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#include "mbed.h"
+
+unsigned long long host_waited = 0;
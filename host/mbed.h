@@ -0,0 +1,123 @@
+// ============================================
+// Host stand-ins for the parts of the mbed library the game uses.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+/****************************************************************************
+ * Just enough of mbed.h for the game's sources to compile and run on a Linux
+ * host, so rendering can be tested and measured off the board (see
+ * host/uLCD_4DGL.h). Nothing here touches hardware:
+ *
+ *   - Serial prints to stdout.
+ *   - DigitalIn reads 0, so a button the game waits for counts as pressed
+ *     straight away.
+ *   - AnalogOut, PwmOut, BusOut and Ticker do nothing.
+ *   - wait, wait_ms and wait_us return at once, but add up how long they
+ *     would have waited; see host_waited_us.
+ *   - Timer measures real time.
+ ***************************************************************************/
+#ifndef HOST_MBED_H
+#define HOST_MBED_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+
+enum PinName {
+    p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15, p16, p17, p18, p19, p20,
+    p21, p22, p23, p24, p25, p26, p27, p28, p29, p30,
+    LED1, LED2, LED3, LED4, USBTX, USBRX
+};
+
+enum PinMode { PullUp, PullDown, PullNone };
+
+/**
+ * The total time, in microseconds, that wait, wait_ms and wait_us would
+ * have waited so far.
+ */
+extern unsigned long long host_waited;
+
+inline unsigned long long host_waited_us() { return host_waited; }
+inline void wait_us(int us) { host_waited += us; }
+inline void wait_ms(int ms) { host_waited += 1000ULL * ms; }
+inline void wait(float s) { host_waited += (unsigned long long)(s * 1000000); }
+
+class Serial {
+public:
+    Serial(PinName /*tx*/, PinName /*rx*/) {}
+    void baud(int /*rate*/) {}
+    int printf(const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n;
+    }
+};
+
+class DigitalIn {
+public:
+    DigitalIn(PinName /*pin*/) {}
+    void mode(PinMode /*pull*/) {}
+    int read() { return 0; }
+    operator int() { return read(); }
+};
+
+class AnalogOut {
+public:
+    AnalogOut(PinName /*pin*/) {}
+    void write(float /*value*/) {}
+    void write_u16(unsigned short /*value*/) {}
+};
+
+class PwmOut {
+public:
+    PwmOut(PinName /*pin*/) {}
+    void period(float /*s*/) {}
+    void write(float /*value*/) {}
+    PwmOut& operator=(float /*value*/) { return *this; }
+};
+
+class BusOut {
+public:
+    BusOut(PinName /*p0*/, PinName /*p1*/, PinName /*p2*/, PinName /*p3*/) {}
+    BusOut& operator=(int /*value*/) { return *this; }
+};
+
+class Ticker {
+public:
+    template <typename T>
+    void attach(T* /*object*/, void (T::* /*method*/)(void), float /*s*/) {}
+    template <typename T>
+    void attach_us(T* /*object*/, void (T::* /*method*/)(void), unsigned /*us*/) {}
+    void detach() {}
+};
+
+class Timer {
+public:
+    Timer() : started(0), elapsed(0) {}
+    void start() { started = now(); }
+    void stop() { elapsed += now() - started; }
+    void reset() { elapsed = 0; started = now(); }
+    int read_ms() { return (int)(elapsed / 1000); }
+    int read_us() { return (int)elapsed; }
+private:
+    static long long now()
+    {
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return t.tv_sec * 1000000LL + t.tv_nsec / 1000;
+    }
+    long long started;
+    long long elapsed;
+};
+
+#endif // HOST_MBED_H
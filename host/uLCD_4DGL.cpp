@@ -0,0 +1,321 @@
+// ============================================
+// Headless stand-in for the uLCD_4DGL library.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#include "uLCD_4DGL.h"
+
+/**
+ * A 5x7 font for the characters ' ' to '~'. Each glyph is 5 columns, left to
+ * right, with the top row in the lowest bit.
+ */
+static const uint8_t font5x7[95][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, // ' ' !
+    {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14}, // " #
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, // $ %
+    {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00}, // & '
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, // ( )
+    {0x14,0x08,0x3E,0x08,0x14}, {0x08,0x08,0x3E,0x08,0x08}, // * +
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, // , -
+    {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02}, // . /
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, // 0 1
+    {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31}, // 2 3
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, // 4 5
+    {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03}, // 6 7
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, // 8 9
+    {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00}, // : ;
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, // < =
+    {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06}, // > ?
+    {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, // @ A
+    {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22}, // B C
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, // D E
+    {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x49,0x49,0x7A}, // F G
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, // H I
+    {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41}, // J K
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x0C,0x02,0x7F}, // L M
+    {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E}, // N O
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, // P Q
+    {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31}, // R S
+    {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, // T U
+    {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F}, // V W
+    {0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, // X Y
+    {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00}, // Z [
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, // \ ]
+    {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40}, // ^ _
+    {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, // ` a
+    {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20}, // b c
+    {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, // d e
+    {0x08,0x7E,0x09,0x01,0x02}, {0x0C,0x52,0x52,0x52,0x3E}, // f g
+    {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, // h i
+    {0x20,0x40,0x44,0x3D,0x00}, {0x7F,0x10,0x28,0x44,0x00}, // j k
+    {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, // l m
+    {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38}, // n o
+    {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, // p q
+    {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20}, // r s
+    {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, // t u
+    {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C}, // v w
+    {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, // x y
+    {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00}, // z {
+    {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, // | }
+    {0x10,0x08,0x08,0x10,0x08},                             // ~
+};
+
+/**
+ * The character cell of each font, in pixels, indexed by FONT_. FONT_8X12
+ * text takes 8 pixel rows, as it does on the uLCD-144; the screens in
+ * graphics.cpp are laid out for that.
+ */
+static const struct { int w, h; } font_cells[] = {
+    {7, 8}, {8, 8}, {8, 8}, {12, 16}, {7, 8}
+};
+
+/**
+ * Packs a 0xRRGGBB color into RGB565, as the library does before sending it.
+ */
+static uint16_t pack(int color)
+{
+    return (uint16_t)((((color >> 19) & 0x1F) << 11) | (((color >> 10) & 0x3F) << 5)
+                      | ((color >> 3) & 0x1F));
+}
+
+uLCD_4DGL::uLCD_4DGL(PinName /*tx*/, PinName /*rx*/, PinName /*rst*/)
+    : baud(9600), n_commands(0), n_bytes(0), screen_bg(BLACK),
+      text_fg(WHITE), text_bg(BLACK), scale_w(1), scale_h(1), col(0), row(0)
+{
+    memset(screen, 0, sizeof(screen));
+    font_w = font_cells[FONT_7X8].w;
+    font_h = font_cells[FONT_7X8].h;
+}
+
+/*
+ * Counts one command of n bytes.
+ */
+void uLCD_4DGL::send(int n)
+{
+    n_commands++;
+    n_bytes += n;
+}
+
+void uLCD_4DGL::put(int x, int y, int color)
+{
+    if (x >= 0 && y >= 0 && x < ULCD_SIZE && y < ULCD_SIZE) screen[y][x] = pack(color);
+}
+
+/*
+ * Like the display, cls also homes the text cursor and resets the text size.
+ */
+void uLCD_4DGL::cls()
+{
+    send(2);
+    for (int y = 0; y < ULCD_SIZE; y++)
+        for (int x = 0; x < ULCD_SIZE; x++)
+            screen[y][x] = pack(screen_bg);
+    col = row = 0;
+    scale_w = scale_h = 1;
+}
+
+void uLCD_4DGL::background_color(int color)
+{
+    send(4);
+    screen_bg = color;
+}
+
+void uLCD_4DGL::filled_rectangle(int x1, int y1, int x2, int y2, int color)
+{
+    send(12);
+    if (x1 > x2) { int t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { int t = y1; y1 = y2; y2 = t; }
+    for (int y = y1; y <= y2; y++)
+        for (int x = x1; x <= x2; x++)
+            put(x, y, color);
+}
+
+void uLCD_4DGL::rectangle(int x1, int y1, int x2, int y2, int color)
+{
+    send(12);
+    draw_line(x1, y1, x2, y1, color);
+    draw_line(x1, y2, x2, y2, color);
+    draw_line(x1, y1, x1, y2, color);
+    draw_line(x2, y1, x2, y2, color);
+}
+
+void uLCD_4DGL::line(int x1, int y1, int x2, int y2, int color)
+{
+    send(12);
+    draw_line(x1, y1, x2, y2, color);
+}
+
+void uLCD_4DGL::triangle(int x1, int y1, int x2, int y2, int x3, int y3, int color)
+{
+    send(16);
+    draw_line(x1, y1, x2, y2, color);
+    draw_line(x2, y2, x3, y3, color);
+    draw_line(x3, y3, x1, y1, color);
+}
+
+void uLCD_4DGL::filled_circle(int x, int y, int r, int color)
+{
+    send(10);
+    for (int dy = -r; dy <= r; dy++) {
+        int dx = 0;
+        while ((dx + 1) * (dx + 1) + dy * dy <= r * r + r) dx++;
+        for (int i = -dx; i <= dx; i++) put(x + i, y + dy, color);
+    }
+}
+
+void uLCD_4DGL::BLIT(int x, int y, int w, int h, int* colors)
+{
+    send(10 + 2 * w * h);
+    for (int j = 0; j < h; j++)
+        for (int i = 0; i < w; i++)
+            put(x + i, y + j, colors[j * w + i]);
+}
+
+/*
+ * Bresenham's line, both ends included.
+ */
+void uLCD_4DGL::draw_line(int x1, int y1, int x2, int y2, int color)
+{
+    int dx = x2 > x1 ? x2 - x1 : x1 - x2;
+    int dy = y2 > y1 ? y1 - y2 : y2 - y1;
+    int sx = x2 > x1 ? 1 : -1;
+    int sy = y2 > y1 ? 1 : -1;
+    int err = dx + dy;
+    while (1) {
+        put(x1, y1, color);
+        if (x1 == x2 && y1 == y2) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x1 += sx; }
+        if (e2 <= dx) { err += dx; y1 += sy; }
+    }
+}
+
+void uLCD_4DGL::locate(int c, int r)
+{
+    send(6);
+    col = c;
+    row = r;
+}
+
+void uLCD_4DGL::color(int color)
+{
+    send(4);
+    text_fg = color;
+}
+
+void uLCD_4DGL::textbackground_color(int color)
+{
+    send(4);
+    text_bg = color;
+}
+
+void uLCD_4DGL::text_width(int width)
+{
+    send(4);
+    scale_w = width < 1 ? 1 : width;
+}
+
+void uLCD_4DGL::text_height(int height)
+{
+    send(4);
+    scale_h = height < 1 ? 1 : height;
+}
+
+void uLCD_4DGL::set_font(int font)
+{
+    send(4);
+    if (font < 0 || font > FONT_7X8) font = FONT_7X8;
+    font_w = font_cells[font].w;
+    font_h = font_cells[font].h;
+}
+
+int uLCD_4DGL::printf(const char* format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    for (const char* c = buffer; *c; c++) {
+        if (*c == '\n') {
+            send(6); // the cursor is moved to the next line
+            newline();
+        } else {
+            send(4);
+            put_char(*c);
+        }
+    }
+    return n;
+}
+
+/*
+ * Draws a character in the cell at the cursor, over the text background,
+ * and moves the cursor on, wrapping at the right edge.
+ */
+void uLCD_4DGL::put_char(char c)
+{
+    int cw = font_w * scale_w, ch = font_h * scale_h;
+    int x0 = col * cw, y0 = row * ch;
+    // a big font draws each pixel of the 5x7 glyph as a block
+    int bw = (font_w >= 12 ? 2 : 1) * scale_w;
+    int bh = (font_h >= 16 ? 2 : 1) * scale_h;
+    const uint8_t* glyph = (c >= ' ' && c <= '~') ? font5x7[c - ' '] : font5x7['?' - ' '];
+
+    for (int y = 0; y < ch; y++)
+        for (int x = 0; x < cw; x++)
+            put(x0 + x, y0 + y, text_bg);
+    for (int gx = 0; gx < 5; gx++)
+        for (int gy = 0; gy < 8; gy++)
+            if (glyph[gx] & (1 << gy))
+                for (int y = 0; y < bh; y++)
+                    for (int x = 0; x < bw; x++)
+                        put(x0 + gx * bw + x, y0 + gy * bh + y, text_fg);
+
+    if (++col >= ULCD_SIZE / cw) newline();
+}
+
+void uLCD_4DGL::newline()
+{
+    col = 0;
+    if (++row >= ULCD_SIZE / (font_h * scale_h)) row = 0;
+}
+
+void uLCD_4DGL::baudrate(int speed)
+{
+    send(4); // at the old rate
+    baud = speed;
+}
+
+uint16_t uLCD_4DGL::pixel(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= ULCD_SIZE || y >= ULCD_SIZE) return 0;
+    return screen[y][x];
+}
+
+bool uLCD_4DGL::save_ppm(const char* path) const
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", ULCD_SIZE, ULCD_SIZE);
+    for (int y = 0; y < ULCD_SIZE; y++) {
+        for (int x = 0; x < ULCD_SIZE; x++) {
+            int p = screen[y][x];
+            int r = p >> 11, g = (p >> 5) & 0x3F, b = p & 0x1F;
+            fputc((r << 3) | (r >> 2), f);
+            fputc((g << 2) | (g >> 4), f);
+            fputc((b << 3) | (b >> 2), f);
+        }
+    }
+    return fclose(f) == 0;
+}
+
+void uLCD_4DGL::reset_stats()
+{
+    n_commands = 0;
+    n_bytes = 0;
+}
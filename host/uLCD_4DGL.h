@@ -0,0 +1,132 @@
+// ============================================
+// Headless stand-in for the uLCD_4DGL library.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+/****************************************************************************
+ * uLCD_4DGL, for host builds
+ *
+ * Implements the uLCD methods the game calls, but instead of sending
+ * commands to a display it draws them into a 128x128 RGB565 copy of the
+ * screen kept in memory. It also counts what every call would have sent
+ * over the serial line, so the cost of drawing a frame can be measured
+ * without the board:
+ *
+ *     uLCD.reset_stats();
+ *     draw_game(...);
+ *     printf("%lu bytes, %.2f ms\n", uLCD.bytes(), uLCD.seconds() * 1000);
+ *     uLCD.save_ppm("frame.ppm");
+ *
+ * Put the host directory ahead of the game's on the include path, so this
+ * header and host/mbed.h replace the mbed libraries; tools/render_bench.cpp
+ * shows the build.
+ *
+ * Byte counts follow the Goldelox serial commands the library sends: a
+ * 2 byte command word followed by 2 bytes per argument, so 12 bytes for a
+ * line or rectangle, 10 for a filled circle, 16 for a triangle, 2 for cls,
+ * and 10 plus 2 per pixel for a BLIT. Every printed character is one 4 byte
+ * PUTCHAR, and a newline moves the cursor with a 6 byte command. A byte
+ * takes 10 bits on the wire (8N1), at the rate last given to baudrate.
+ * Replies from the display are not counted.
+ *
+ * Text is drawn with a 5x7 font, in cells laid out like the display's, so
+ * it lands where it would on the screen but does not look exactly the same.
+ ***************************************************************************/
+#ifndef ULCD_4DGL_H
+#define ULCD_4DGL_H
+
+#include "mbed.h"
+#include <stdint.h>
+
+// Common colors
+#define BLACK   0x000000
+#define WHITE   0xFFFFFF
+#define RED     0xFF0000
+#define GREEN   0x00FF00
+#define BLUE    0x0000FF
+#define LGREY   0xBFBFBF
+#define DGREY   0x5F5F5F
+
+// Fonts, for set_font
+#define FONT_5X7   0
+#define FONT_8X8   1
+#define FONT_8X12  2
+#define FONT_12X16 3
+#define FONT_7X8   4
+
+/** The width and height of the screen, in pixels */
+#define ULCD_SIZE 128
+
+class uLCD_4DGL {
+public:
+    uLCD_4DGL(PinName tx, PinName rx, PinName rst);
+
+    // Drawing
+    void cls();
+    void background_color(int color);
+    void filled_rectangle(int x1, int y1, int x2, int y2, int color);
+    void rectangle(int x1, int y1, int x2, int y2, int color);
+    void line(int x1, int y1, int x2, int y2, int color);
+    void triangle(int x1, int y1, int x2, int y2, int x3, int y3, int color);
+    void filled_circle(int x, int y, int r, int color);
+    void BLIT(int x, int y, int w, int h, int* colors);
+
+    // Text
+    void locate(int col, int row);
+    void color(int color);
+    void textbackground_color(int color);
+    void text_width(int width);
+    void text_height(int height);
+    void set_font(int font);
+    int printf(const char* format, ...);
+
+    // Serial line
+    void baudrate(int speed);
+
+    /**
+     * Returns the pixel at (x,y) in RGB565, as the screen would show it.
+     */
+    uint16_t pixel(int x, int y) const;
+
+    /**
+     * Writes the screen to a binary PPM file. Returns false if the file
+     * can't be written.
+     */
+    bool save_ppm(const char* path) const;
+
+    /** The number of commands sent since the last reset_stats */
+    unsigned long commands() const { return n_commands; }
+
+    /** The number of bytes sent since the last reset_stats */
+    unsigned long bytes() const { return n_bytes; }
+
+    /** The time those bytes take on the wire at the current baudrate */
+    double seconds() const { return n_bytes * 10.0 / baud; }
+
+    /** Starts counting commands and bytes from zero */
+    void reset_stats();
+
+private:
+    void send(int n);
+    void put(int x, int y, int color);
+    void draw_line(int x1, int y1, int x2, int y2, int color);
+    void put_char(char c);
+    void newline();
+
+    uint16_t screen[ULCD_SIZE][ULCD_SIZE];
+    int baud;
+    unsigned long n_commands, n_bytes;
+
+    int screen_bg;          // color cls fills with
+    int text_fg, text_bg;
+    int font_w, font_h;     // cell of the current font, unscaled
+    int scale_w, scale_h;   // text_width, text_height
+    int col, row;
+};
+
+#endif // ULCD_4DGL_H
@@ -0,0 +1,43 @@
+// ============================================
+// Compile-time index lists, for building arrays in constexpr functions.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+/****************************************************************************
+ * A C++11 constexpr function is a single return statement, so it can't fill
+ * an array in a loop. It can expand an index list instead:
+ *
+ *     template <unsigned... I>
+ *     constexpr Squares squares(Indices<I...>) { return Squares{{(I * I)...}}; }
+ *     constexpr Squares SQUARES = squares(MakeIndices<10>::type());
+ *
+ * MakeIndices splits the list in halves rather than growing it one index at
+ * a time, which keeps the template nesting logarithmic in N. Used by
+ * map_bake.h and sprite_bake.h.
+ ***************************************************************************/
+#ifndef INDICES_H
+#define INDICES_H
+
+/** A compile-time list of indices, to expand an array element by element */
+template <unsigned... I> struct Indices {};
+
+template <class A, class B> struct Join;
+template <unsigned... A, unsigned... B>
+struct Join<Indices<A...>, Indices<B...> > {
+    typedef Indices<A..., (sizeof...(A) + B)...> type;
+};
+
+/** Indices<0, 1, ..., N-1> */
+template <unsigned N> struct MakeIndices {
+    typedef typename Join<typename MakeIndices<N / 2>::type,
+                          typename MakeIndices<N - N / 2>::type>::type type;
+};
+template <> struct MakeIndices<0> { typedef Indices<> type; };
+template <> struct MakeIndices<1> { typedef Indices<0> type; };
+
+#endif // INDICES_H
@@ -12,7 +12,9 @@
 #include "globals.h"
 #include "hardware.h"
 #include "map.h"
+#include "map_layouts.h"
 #include "graphics.h"
+#include "framebuffer.h"
 #include "speech.h"
 #include <math.h>
 
@@ -100,7 +102,17 @@ int get_action(GameInputs inputs)
 // Helper Functions
 /////////////////////////
 
-
+/**
+ * checks whether the player can teleport one step in direction dir.
+ * the run checked is the same one the single getters used to check:
+ * the 2nd through 5th tiles away from the player in that direction.
+ */
+bool can_teleport(int dir)
+{
+    int x = Player.x + (dir == DIR_EAST) - (dir == DIR_WEST);
+    int y = Player.y + (dir == DIR_SOUTH) - (dir == DIR_NORTH);
+    return map_ray(x, y, dir, 4) == 4;
+}
 
 
 
@@ -115,11 +127,13 @@ int get_action(GameInputs inputs)
  * 
  * Return values are defined below. FULL_DRAW indicates that for this frame,
  * draw_game should not optimize drawing and should draw every tile, even if
- * the player has not moved.
+ * the player has not moved. BUBBLE_DRAW indicates that a speech bubble was
+ * shown, so draw_game should also redraw everything the bubble covered.
  */
 #define NO_RESULT 0
 #define GAME_OVER 1
 #define FULL_DRAW 2
+#define BUBBLE_DRAW 3
 int update_game(int action)
 {
     // save player previous location before updating
@@ -132,11 +146,20 @@ int update_game(int action)
     MapItem* item = NULL;
 
     // variables
-    MapItem* north = get_north(Player.x, Player.y);
-    MapItem* south = get_south(Player.x, Player.y);
-    MapItem* east = get_east(Player.x, Player.y);
-    MapItem* west = get_west(Player.x, Player.y);
-    MapItem* here = get_here(Player.x, Player.y);
+    // fetch the 3x3 neighborhood of the player with a single lookup
+    MapItem* around[9];
+    get_neighborhood(Player.x, Player.y, 1, around);
+    // empty cells hold no item; give them one so the checks below can look
+    // at the type of every neighbor
+    static MapItem nothing = {CLEAR, draw_nothing, true, NULL};
+    for (int k = 0; k < 9; k++) {
+        if (!around[k]) around[k] = &nothing;
+    }
+    MapItem* north = around[NEIGHBOR(1, 0, -1)];
+    MapItem* south = around[NEIGHBOR(1, 0, 1)];
+    MapItem* east = around[NEIGHBOR(1, 1, 0)];
+    MapItem* west = around[NEIGHBOR(1, -1, 0)];
+    MapItem* here = around[NEIGHBOR(1, 0, 0)];
 
 
     switch(action)
@@ -149,13 +172,12 @@ int update_game(int action)
             // check item north
             // if item north is walkable OR ramblin mode is activated
             // player can only walk through a door if they have the key
-            if (north->walkable || Player.ramblin_active) {
+            if (map_walkable(Player.x, Player.y-1) || Player.ramblin_active) {
                 // teleport = move 4 tiles at a time
-                if (Player.teleporting && get_north(Player.x, Player.y-4)->walkable && get_north(Player.x, Player.y-3)->walkable
-                    && get_north(Player.x, Player.y-2)->walkable && get_north(Player.x, Player.y-1)->walkable) {
+                if (Player.teleporting && can_teleport(DIR_NORTH)) {
                     Player.x = Player.x;
                     Player.y -= 4;
-                    return FULL_DRAW;
+                    return NO_RESULT; // draw_game scrolls the view along
                 }
                 // then walk up by updating player coordinates
                 Player.x = Player.x;
@@ -169,14 +191,14 @@ int update_game(int action)
                 const char *lines[] = {"Ouch!", "You stubbed", "your toe on", "a pebble!!", "Lose 10 health."};
                 long_speech(lines, 5);
                 Player.health -= 10;
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             if (north->type == HOLE) {
                 // pebbles hurt your toes, so decrease health by 5
                 const char *lines[] = {"Oh no!", "", "You fell into", "a hole!", "Lose 10 health."};
                 long_speech(lines, 5);
                 Player.health -= 10;
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             ///////////////////////////////
             // Items that Help Player
@@ -191,7 +213,7 @@ int update_game(int action)
                     const char *lines[] = {"Already at", "max health."};
                     long_speech(lines, 2);
                 }
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             if (north->type == MUSHROOM) {
                 // power-ups that increase health by 5
@@ -203,7 +225,7 @@ int update_game(int action)
                     const char *lines[] = {"Already at", "max health."};
                     long_speech(lines, 2);
                 }
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             break; 
         // end go up case
@@ -212,13 +234,12 @@ int update_game(int action)
             // check item west
             // if item west is walkable OR ramblin mode is activated
             // player can only walk through a door if they have the key
-            if (west->walkable || Player.ramblin_active) {
+            if (map_walkable(Player.x-1, Player.y) || Player.ramblin_active) {
                 // teleport = move 4 tiles at a time
-                if (Player.teleporting && get_west(Player.x-4, Player.y)->walkable && get_west(Player.x-3, Player.y)->walkable
-                    && get_west(Player.x-2, Player.y)->walkable && get_west(Player.x-1, Player.y)->walkable) {
+                if (Player.teleporting && can_teleport(DIR_WEST)) {
                     Player.x -= 4;
                     Player.y = Player.y;
-                    return FULL_DRAW;
+                    return NO_RESULT; // draw_game scrolls the view along
                 }
                 Player.x -= 1;
                 Player.y = Player.y;
@@ -231,14 +252,14 @@ int update_game(int action)
                 const char *lines[] = {"Ouch!", "You stubbed", "your toe on", "a pebble!!", "Lose 10 health."};
                 long_speech(lines, 5);
                 Player.health -= 10;
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             if (west->type == HOLE) {
                 // pebbles hurt your toes, so decrease health by 5
                 const char *lines[] = {"Oh no!", "", "You fell into", "a hole!", "Lose 10 health."};
                 long_speech(lines, 5);
                 Player.health -= 10;
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             ///////////////////////////////
             // Items that Help Player
@@ -253,7 +274,7 @@ int update_game(int action)
                     const char *lines[] = {"Already at", "max health."};
                     long_speech(lines, 2);
                 }
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             if (west->type == MUSHROOM) {
                 // power-ups that increase health by 5
@@ -265,7 +286,7 @@ int update_game(int action)
                     const char *lines[] = {"Already at", "max health."};
                     long_speech(lines, 2);
                 }
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             break;
         // end go left case
@@ -274,13 +295,12 @@ int update_game(int action)
             // check item south
             // if item south is walkable OR ramblin mode is activated
             // player can only walk through a door if they have the key
-            if (south->walkable || Player.ramblin_active) {
+            if (map_walkable(Player.x, Player.y+1) || Player.ramblin_active) {
                 // teleport = move 4 tiles at a time
-                if (Player.teleporting && get_south(Player.x, Player.y+4)->walkable && get_south(Player.x, Player.y+3)->walkable
-                    && get_south(Player.x, Player.y+2)->walkable && get_south(Player.x, Player.y+1)->walkable) {
+                if (Player.teleporting && can_teleport(DIR_SOUTH)) {
                     Player.x = Player.x;
                     Player.y += 4;
-                    return FULL_DRAW;
+                    return NO_RESULT; // draw_game scrolls the view along
                 }
                 Player.x = Player.x;
                 Player.y += 1;
@@ -293,14 +313,14 @@ int update_game(int action)
                 const char *lines[] = {"Ouch!", "You stubbed", "your toe on", "a pebble!!", "Lose 10 health."};
                 long_speech(lines, 5);
                 Player.health -= 10;
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             if (south->type == HOLE) {
                 // pebbles hurt your toes, so decrease health by 5
                 const char *lines[] = {"Oh no!", "", "You fell into", "a hole!", "Lose 10 health."};
                 long_speech(lines, 5);
                 Player.health -= 10;
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             ///////////////////////////////
             // Items that Help Player
@@ -315,7 +335,7 @@ int update_game(int action)
                     const char *lines[] = {"Already at", "max health."};
                     long_speech(lines, 2);
                 }
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             if (south->type == MUSHROOM) {
                 // power-ups that increase health by 5
@@ -327,7 +347,7 @@ int update_game(int action)
                     const char *lines[] = {"Already at", "max health."};
                     long_speech(lines, 2);
                 }
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             break;
         // end go down case
@@ -336,13 +356,12 @@ int update_game(int action)
             // check item east
             // if item east is walkable OR ramblin mode is activated
             // player can only walk through a door if they have the key
-            if (east->walkable || Player.ramblin_active) {
+            if (map_walkable(Player.x+1, Player.y) || Player.ramblin_active) {
                 // teleport = move 4 tiles at a time
-                if (Player.teleporting && get_east(Player.x+4, Player.y)->walkable && get_east(Player.x+3, Player.y)->walkable
-                    && get_east(Player.x+2, Player.y)->walkable && get_east(Player.x+1, Player.y)->walkable) {
+                if (Player.teleporting && can_teleport(DIR_EAST)) {
                     Player.x += 4;
                     Player.y = Player.y;
-                    return FULL_DRAW;
+                    return NO_RESULT; // draw_game scrolls the view along
                 }
                 Player.x += 1;
                 Player.y = Player.y;
@@ -355,14 +374,14 @@ int update_game(int action)
                 const char *lines[] = {"Ouch!", "You stubbed", "your toe on", "a pebble!!", "Lose 10 health."};
                 long_speech(lines, 5);
                 Player.health -= 10;
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             if (east->type == HOLE) {
                 // pebbles hurt your toes, so decrease health by 5
                 const char *lines[] = {"Oh no!", "", "You fell into", "a hole!", "Lose 10 health."};
                 long_speech(lines, 5);
                 Player.health -= 10;
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             ///////////////////////////////
             // Items that Help Player
@@ -377,7 +396,7 @@ int update_game(int action)
                     const char *lines[] = {"Already at", "max health."};
                     long_speech(lines, 2);
                 }
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             if (east->type == MUSHROOM) {
                 // power-ups that increase health by 5
@@ -389,7 +408,7 @@ int update_game(int action)
                     const char *lines[] = {"Already at", "max health."};
                     long_speech(lines, 2);
                 }
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             break;
         // end go right case
@@ -401,14 +420,14 @@ int update_game(int action)
                 Player.teleporting = false;
                 const char* speech[] = {"Teleporting mode", "deactivated.", "You now walk at", "normal speed."};
                 long_speech(speech, 4);
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             } else {
                 // activate teleporting mode
                 Player.teleporting = true;
                 // speech bubble
                 const char* speech[] = {"Teleporting mode", "activated.", "You can now move", "4 tiles at once."};
                 long_speech(speech, 4);
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             break;
         } // end run button case
@@ -454,8 +473,8 @@ int update_game(int action)
                     "out for power-ups.", "Good luck,", "brave stranger."};
                     long_speech(speech, 33);
                 }
-                // return FULL_DRAW to redraw the game
-                return FULL_DRAW;
+                // return BUBBLE_DRAW to redraw what the bubble covered
+                return BUBBLE_DRAW;
             }
 
             ///////////////////////////
@@ -472,8 +491,8 @@ int update_game(int action)
                     const char* speech[] = {"Ramblin Wreck", "car is on the", "other side of", "this locked door", 
                     "Find the key", "and try again."};
                     long_speech(speech, 4);
-                    // return FULL_DRAW to redraw the scene
-                    return FULL_DRAW;
+                    // return BUBBLE_DRAW to redraw what the bubble covered
+                    return BUBBLE_DRAW;
                 }
             }
 
@@ -492,14 +511,16 @@ int update_game(int action)
                     Map *small = set_active_map(1);
                     // set player coordinates to small map
                     Player.x = Player.y = map_width()/4;
+                    // return FULL_DRAW to draw the new map
+                    return FULL_DRAW;
                 } else {
                     // speech bubbles to talk to npc
                     const char* speech[] = {"Hmmm...", "what an ", "interesting", "cave...", "You might",
                     "want to try", "talking to", "someone more", "knowledgeable.."};
                     long_speech(speech, 9);
                 }
-                // return FULL_DRAW to redraw the scene
-                return FULL_DRAW;
+                // return BUBBLE_DRAW to redraw what the bubble covered
+                return BUBBLE_DRAW;
             }
 
             ///////////////////////////
@@ -561,7 +582,7 @@ int update_game(int action)
                     Player.fancy_hat = true;
                     // can only find gift box once, so erase it
                     // draw_nothing(0, 25);
-                    return FULL_DRAW;
+                    return BUBBLE_DRAW;
             }
 
             //////////////////////////////
@@ -579,8 +600,8 @@ int update_game(int action)
                     // speech bubble
                     speech("WATER spell", "equipped.");
                 }
-                // return FULL_DRAW to redraw the scene
-                return FULL_DRAW;
+                // return BUBBLE_DRAW to redraw what the bubble covered
+                return BUBBLE_DRAW;
             }
             // check if near a FIRE spell
             if (north->type == FIRE || south->type == FIRE || east->type == FIRE || west->type == FIRE || here->type == FIRE) {
@@ -593,8 +614,8 @@ int update_game(int action)
                     // speech bubble
                     speech("FIRE spell", "equipped.");
                 }
-                // return FULL_DRAW to redraw the scene
-                return FULL_DRAW;
+                // return BUBBLE_DRAW to redraw what the bubble covered
+                return BUBBLE_DRAW;
             }
             // check if near an EARTH spell
             if (north->type == EARTH || south->type == EARTH || east->type == EARTH || west->type == EARTH || here->type == EARTH) {
@@ -607,8 +628,8 @@ int update_game(int action)
                     // speech bubble
                     speech("EARTH spell", "equipped.");
                 }
-                // return FULL_DRAW to redraw the scene
-                return FULL_DRAW;
+                // return BUBBLE_DRAW to redraw what the bubble covered
+                return BUBBLE_DRAW;
             }
 
             /////////////////////////////////
@@ -628,8 +649,8 @@ int update_game(int action)
                     Player.health -= 25;
                     // unequip spell
                     Player.water_spell = false;
-                    // return FULL_DRAW to redraw the scene
-                    return FULL_DRAW;
+                    // return BUBBLE_DRAW to redraw what the bubble covered
+                    return BUBBLE_DRAW;
                 }
                 // if earth -> spell not very effective
                 if (Player.earth_spell) {
@@ -641,8 +662,8 @@ int update_game(int action)
                     Player.health -= 15;
                     // unequip spell
                     Player.earth_spell = false;
-                    // return FULL_DRAW to redraw the scene
-                    return FULL_DRAW;
+                    // return BUBBLE_DRAW to redraw what the bubble covered
+                    return BUBBLE_DRAW;
                 }
                 // if fire -> Buzz defeated.
                 if (Player.fire_spell) {
@@ -657,14 +678,14 @@ int update_game(int action)
                     Player.game_solved = true;
                     // draw Slain Buzz
                     add_slain_buzz(map_width()/2, map_width()/2);
-                    // return FULL_DRAW to redraw the scene
-                    return FULL_DRAW;
+                    // return BUBBLE_DRAW to redraw what the bubble covered
+                    return BUBBLE_DRAW;
                 }
                 else {
                     const char* speech[] = {"No spell", "equipped.", "Damage: 5", ""};
                     long_speech(speech, 4);
                     Player.health -= 5;
-                    return FULL_DRAW;
+                    return BUBBLE_DRAW;
                 }
             }
 
@@ -678,6 +699,7 @@ int update_game(int action)
                     }
                 }
                 uLCD.cls();
+                fb_clear();
                 return FULL_DRAW;
             }
             break;
@@ -710,8 +732,8 @@ int update_game(int action)
             const char* speech[] = {"Inventory", "of Spells...", "Water Spell:", num_water, 
             "Earth Spell:", num_earth, "Fire Spell:", num_fire, "Fancy Hat:", hat, ""};
             long_speech(speech, 11);
-            // return FULL_DRAW to redraw the scene
-            return FULL_DRAW;
+            // return BUBBLE_DRAW to redraw what the bubble covered
+            return BUBBLE_DRAW;
             break;
         }
         // end menu button case
@@ -727,14 +749,14 @@ int update_game(int action)
                 Player.ramblin_active = false;
                 const char* speech[] = {"Ramblin' mode", "deactivated.", "You cannot walk", "through walls"};
                 long_speech(speech, 4);
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             } else {
                 // activate ramblin mode
                 Player.ramblin_active = true;
                 // speech bubble
                 const char* speech[] = {"Ramblin' mode", "activated.", "You can now walk", "through walls"};
                 long_speech(speech, 4);
-                return FULL_DRAW;
+                return BUBBLE_DRAW;
             }
             break;
         }
@@ -753,15 +775,54 @@ int update_game(int action)
 
 /**
  * entry point for frame drawing.
- * called once per iteration of the game loop.
- * this draws all tiles on the screen, followed by the status bars.
- * unless init is nonzero, this function will optimize drawing by only
- * drawing tiles that have changed from the previous frame.
+ * called once per iteration of the game loop with the result of update_game.
+ * this draws all tiles into the framebuffer, followed by the status bars,
+ * and then sends the parts that changed to the screen.
+ * unless result is FULL_DRAW, this function will optimize drawing by only
+ * drawing tiles that scrolled or changed on the map since the previous
+ * frame; after BUBBLE_DRAW, the rows of tiles under the speech bubble are
+ * drawn too. when the player took one step or teleported, the picture
+ * already in the framebuffer is scrolled instead, and only the tiles that
+ * came into view or changed on the map are drawn.
  */
-void draw_game(int init)
+#define VIEW_WIDTH  11
+#define VIEW_HEIGHT 9
+#define VIEW_U 3    // the screen position of the top left tile
+#define VIEW_V 15
+#define BUBBLE_FIRST_ROW 5  // the first row of tiles the speech bubble covers
+void draw_game(int result)
 {
+    int init = (result == FULL_DRAW);
+    int bubble = (result == BUBBLE_DRAW);
+
+    // a plain step of one tile, or a teleport of 4, scrolls what is already
+    // drawn along with the player instead of drawing it all again
+    int dx = Player.x - Player.px;
+    int dy = Player.y - Player.py;
+    int scroll = (result == NO_RESULT) && (dx == 0 || dy == 0)
+                 && (abs(dx + dy) == 1 || abs(dx + dy) == 4);
+    if (scroll) {
+        // the status bars are drawn over the top and bottom rows of tiles,
+        // so only the rows between them are scrolled. the top and bottom
+        // rows are compared tile by tile, as when not scrolling
+        fb_scroll(VIEW_U, VIEW_V + 11, VIEW_WIDTH*11, (VIEW_HEIGHT-2)*11, -dx*11, -dy*11, 11);
+    }
+
     // draw game border first
-    if(init) draw_border();
+    if(init || bubble) draw_border();
+
+    // fetch the visible tiles around the current and previous position, one
+    // row at a time. both windows are VIEW_WIDTH x VIEW_HEIGHT, row-major.
+    static MapItem* curr_items[VIEW_WIDTH*VIEW_HEIGHT];
+    static MapItem* prev_items[VIEW_WIDTH*VIEW_HEIGHT];
+    get_region(Player.x - 5, Player.y - 4, VIEW_WIDTH, VIEW_HEIGHT, curr_items);
+    get_region(Player.px - 5, Player.py - 4, VIEW_WIDTH, VIEW_HEIGHT, prev_items);
+    // and which of the visible cells changed on the map since they were drawn
+    static unsigned char changed[VIEW_WIDTH*VIEW_HEIGHT];
+    map_consume_dirty(Player.x - 5, Player.y - 4, VIEW_WIDTH, VIEW_HEIGHT, changed);
+    int w = map_width();
+    int h = map_height();
+
     // iterate over all visible map tiles
     for (int i = -5; i <= 5; i++) // iterate over columns of tiles
     {
@@ -772,27 +833,43 @@ void draw_game(int init)
             int x = i + Player.x;
             int y = j + Player.y;
 
-            // compute the previous map (px, py) of this tile
-            int px = i + Player.px;
-            int py = j + Player.py;
-
             // compute u,v coordinates for drawing
-            int u = (i+5)*11 + 3;
-            int v = (j+4)*11 + 15;
+            int u = (i+5)*11 + VIEW_U;
+            int v = (j+4)*11 + VIEW_V;
 
             // figure out what to draw
             DrawFunc draw = NULL;
+            int redraw = init || (bubble && j+4 >= BUBBLE_FIRST_ROW);
+            int scrolled = scroll && j != -4 && j != 4;
+            if (scrolled)
+            {
+                // draw the tiles that scrolled into view, and the ones the
+                // player was drawn over before the move
+                int pi = i + dx;
+                int pj = j + dy;
+                redraw = pi < -5 || pi > 5 || pj < -3 || pj > 3
+                         || ((pi == -1 || pi == 0) && (pj == -1 || pj == 0));
+            }
+            // a wall was drawn here if this spot was off the map
+            int px = i + Player.px;
+            int py = j + Player.py;
+            int was_wall = px < 0 || py < 0 || px >= w || py >= h;
 //            if (init && i == 0 && j == 0) // only draw the player on init
             if ( i == 0 && j == 0) // always draw the player
             {
+                // the player's own tile is never drawn, so clear the one that
+                // scrolled under the player
+                if (scroll) draw_nothing(u, v);
                 draw_player(u, v, Player.has_key, Player.fancy_hat);
                 continue;
             }
-            else if (x >= 0 && y >= 0 && x < map_width() && y < map_height()) // current (i,j) in the map
+            else if (x >= 0 && y >= 0 && x < w && y < h) // current (i,j) in the map
             {
-                MapItem* curr_item = get_here(x, y);
-                MapItem* prev_item = get_here(px, py);
-                if (init || curr_item != prev_item) // only draw if they're different
+                int n = (j+4)*VIEW_WIDTH + (i+5);
+                MapItem* curr_item = curr_items[n];
+                MapItem* prev_item = prev_items[n];
+                // only draw if they're different, or the map changed here
+                if (redraw || (!scrolled && (curr_item != prev_item || was_wall)) || changed[n])
                 {
                     if (curr_item) // There's something here! Draw it
                     {
@@ -803,13 +880,8 @@ void draw_game(int init)
                         draw = draw_nothing;
                     }
                 }
-                else if (curr_item && curr_item->type == CLEAR)
-                {
-                    // this is a special case for erasing things like doors.
-                    draw = curr_item->draw; // i.e. draw_nothing
-                } 
             }
-            else if (init) // if doing a full draw, but out of bounds, draw the walls.
+            else if (redraw || (!scrolled && !was_wall)) // if doing a full draw, or this spot just went off the map, draw the walls.
             {
                 draw = draw_wall;
             }
@@ -818,19 +890,13 @@ void draw_game(int init)
             if (draw) draw(u, v);
         }
     }
-    // draw status bars
-    if(init) {
-        uLCD.filled_rectangle(0, 0, 127, 17, 0xf6f6f6);
+    // draw status bars (each clears its own background)
+    if (init || bubble || Player.px != Player.x || Player.py != Player.y) {
         draw_upper_status(Player.x, Player.y, Player.has_key);
-        uLCD.filled_rectangle(0, 112, 127, 117, 0xf6f6f6);
-        draw_lower_status(Player.health);
-    }
-    if (Player.px != Player.x || Player.py != Player.y) {
-        uLCD.filled_rectangle(0, 0, 127, 17, 0xf6f6f6);
-        draw_upper_status(Player.x, Player.y, Player.has_key);
-        uLCD.filled_rectangle(0, 112, 127, 117, 0xf6f6f6);
         draw_lower_status(Player.health);
     }
+    // send whatever is left of the frame to the screen
+    fb_flush();
 }
 
 
@@ -843,161 +909,49 @@ void draw_game(int init)
 // Map Intialization
 /////////////////////////
 
-// important locations for all maps
-// location of the center of the cave
-int cb_loc[2] = {5,20};
-// location of the entrance to secret map
-
+// the maps themselves are ASCII layouts in map_layouts.cpp, baked into map
+// file images in flash while compiling. starting a map just attaches its
+// image, so the static content of the maps costs no time and no heap.
+
+// the binary map files (see map_format.h) live on the mbed's USB drive.
+// build with MAP_EXPORT to write them, and with MAP_FILES to start from them.
+#ifndef MAP_DIR
+#define MAP_DIR "/local/"
+#endif
+#if defined(TARGET_LPC1768) && (defined(MAP_FILES) || defined(MAP_EXPORT))
+LocalFileSystem local("local");
+#endif
+static const char* const MAP_FILE_NAMES[] = {
+    MAP_DIR "MAIN.MAP", MAP_DIR "SMALL.MAP", MAP_DIR "SECRET.MAP"
+};
 
 /**
- * initialize the main world map.
- * add walls around the edges, interior chambers,
- * and plants in the background so you can see motion.
+ * Builds map m from its built-in layout, or from its map file if MAP_FILES
+ * is defined and the file is on the USB drive.
  */
-void init_main_map()
+void build_layout_map(int m, void* /*context*/)
 {
-    // initialize and set current map to the first map
-    Map* map = set_active_map(0);
-
-    /////////////////////////
-    // Initial Environmnet
-    /////////////////////////
-
-    // Add random plants
-    pc.printf("Adding Plants!\r\n");
-    for(int i = map_width() + 3; i < map_area(); i += 39)
-    {
-        add_plant(i % map_width(), i / map_width());
-        add_bush((i + 5)/ map_height(), (i+5) % map_height());
-    }
-    for (int i = map_width() + 3; i < map_area(); i += 63)
-    {
-        add_pebble(i / (map_width()/2), i % map_width() + 5);
-        add_power_up(i % map_height() - 2, i / (map_height()/3));
-    }
-
-    // add wall borders 
-    pc.printf("Adding walls!\r\n");
-    add_wall(0,              0,              HORIZONTAL, map_width());
-    add_wall(0,              map_height()-1, HORIZONTAL, map_width());
-    add_wall(0,              0,              VERTICAL,   map_height());
-    add_wall(map_width()-1,  0,              VERTICAL,   map_height());
-    
-    // add extra chamber borders 
-    pc.printf("Add extra chamber\r\n");
-    add_wall(30, 0, VERTICAL, 10);
-    add_wall(30, 10, HORIZONTAL, 10);
-    add_wall(39, 0, VERTICAL, 10);
-    add_door(33, 10, HORIZONTAL, 4);
-
-    // add extra cave to Buzz's evil lair
-    pc.printf("Add cave\r\n");
-    add_cave(cb_loc[0],cb_loc[1],1,1,5,5);      // cave is set as a 4x4 block to be bigger
-    add_cave(cb_loc[0]+1,cb_loc[1],2,1,5,5);
-    add_cave(cb_loc[0],cb_loc[1]+1,3,1,5,5);
-    add_cave(cb_loc[0]+1,cb_loc[1]+1,4,1,5,5);
-
-    pc.printf("Initial environment completed\r\n");
-
-    ///////////////////////////////////
-    // Characters and Items for Map
-    ///////////////////////////////////
-
-    // add NPC
-    add_npc(20, 5);
-
-    // add any extra characters/items here for your project
-    add_wreck(35, 9);
-    // add_gift_box(48, 48);
-    add_hole(10, 10);
-    add_hole(20, 20);
-    add_hole(30, 30);
-    add_hole(40, 40);
-
-    // add secret entrance to another map
-    add_secret_entrance(48, 48, 1, 4, 4);
-
-    // print out map
-    print_map();
+#ifdef MAP_FILES
+    if (map_load_file(m, MAP_FILE_NAMES[m])) return;
+#endif
+    map_attach(m, MAP_LAYOUTS[m].image, MAP_LAYOUTS[m].size);
 }
 
-
-
-
-
-
 /**
- * initialize the small map.
- * add walls around the edges, Wizard Buzz in the center,
- * spells for the player to use to defeat Buzz, 
- * and stairs back up to the main map.
-**/
-void init_small_map()
+ * Writes every map to its map file.
+ */
+void export_maps()
 {
-    // set current map to the second map
-    Map* small = set_active_map(1);
-
-    // add wall borders to small map
-    pc.printf("Adding walls!\r\n");
-    add_wall(0,              0,         HORIZONTAL, 16);
-    add_wall(0,              15,        HORIZONTAL, 16);
-    add_wall(0,              0,         VERTICAL,   16);
-    add_wall(15,             0,         VERTICAL,   16);
-
-    // add three spells at different locations
-    add_water(5, 5);
-    add_fire(13, 1);
-    add_earth(8, 12);
-
-    // add Wizard Buzz at the center of the map
-    add_buzz(map_width()/2, map_height()/2);
-
-    // add stairs back to main (map 0)
-    add_stairs(4, 6, 0, cb_loc[0], cb_loc[1]);
-
-    // additional items
-    add_pebble(9,5);
-    add_power_up(13, 12);
-
-    // print out map
-    print_map();
+    for (int m = 0; m < NUM_MAP_LAYOUTS; m++) {
+        set_active_map(m);
+        if (map_save(MAP_FILE_NAMES[m])) pc.printf("Wrote %s\r\n", MAP_FILE_NAMES[m]);
+        else pc.printf("Could not write %s\r\n", MAP_FILE_NAMES[m]);
+    }
 }
 
 
-
-/**
- * initialize the secret map.
- * add walls around the edges, gift box in the center,
- * power-ups for the player to gain health,
- * and stairs back up to the main map.
-**/
-void init_secret_map()
-{
-    // set current map to the second map
-    Map* secret = set_active_map(2);
-
-    // add wall borders to small map
-    pc.printf("Adding walls!\r\n");
-    add_wall(0,              0,          HORIZONTAL, 12);
-    add_wall(0,              11,         HORIZONTAL, 12);
-    add_wall(0,              0,          VERTICAL,   12);
-    add_wall(11,             0,          VERTICAL,   12);
-
-    // add stairs back to main (map 0)
-    add_secret_stairs(4, 6, 0, 48, 48);
-
-    // additional items
-    add_power_up(9, 9);
-    add_power_up(7, 7);
-    add_mushroom(10, 10);
-    
-    // add gift box to center of map
-    add_gift_box(map_width()/2+1, map_height()/2+1);
-
-    // print out map
-    print_map();
-}
-
+// the number of cells map_compact tidies up in a frame with time to spare
+#define COMPACT_CELLS 64
 
 /**
  * program entry point!
@@ -1050,12 +1004,16 @@ int main()
         wait(.5);
     }
     uLCD.cls();
+    fb_clear();
 
-    // initialize the maps
+    // register the maps; each one is built the first time it is entered
     maps_init();
-    init_main_map();
-    init_small_map();
-    init_secret_map();
+    for (int m = 0; m < NUM_MAP_LAYOUTS; m++) {
+        map_create(MAP_LAYOUTS[m].width, MAP_LAYOUTS[m].height, MAP_MAPPED, build_layout_map, NULL);
+    }
+#ifdef MAP_EXPORT
+    export_maps();
+#endif
     
     // initialize game state
     set_active_map(0);
@@ -1066,7 +1024,7 @@ int main()
     Player.health = Player.max_health = 50;
 
     // initial drawing
-    draw_game(true);
+    draw_game(FULL_DRAW);
 
     ////////////////////////
     // Main Game Loop
@@ -1112,7 +1070,7 @@ int main()
         if (result == GAME_OVER) {
             const char* array[] = {"Door unlocked!", "", "The 2nd key", "starts the car.", "Push action again", "to end the game!"};
             long_speech(array, 6);
-            draw_game(true);
+            draw_game(FULL_DRAW);
             // wait for action button to continue
             while (1) {
                 if (!button1) {
@@ -1145,9 +1103,9 @@ int main()
         }
 
         // draw screen to uLCD
-        bool full_draw = false;
-        if (result == FULL_DRAW) full_draw = true;
-        draw_game(full_draw);
+        draw_game(result);
+        // tidy up the map a little while there is time to spare
+        if (t.read_ms() < 100) map_compact(COMPACT_CELLS);
         // frame delay
         t.stop();
         int dt = t.read_ms();
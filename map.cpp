@@ -13,14 +13,71 @@
 #include "globals.h"
 #include "graphics.h"
 #include "hash_table.h"
+#include "typed_hash_table.h"
+#include "map_format.h"
+#include "arena.h"
+
+// map files are memory-mapped where the OS can do it (host builds)
+#if defined(__unix__) || defined(__APPLE__)
+#define HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct ChunkStore;
+struct MappedStore;
+struct Portal;
+
+/**
+ * the hash of the maps' tables, over XY_KEY keys (see below). it is a functor,
+ * so TypedHashTable inlines it into every probe instead of calling through a
+ * pointer. the table only keeps the low bits of the hash, so the key is mixed
+ * first (the hash_xorshift finalizer): returned as-is, a wall along a row
+ * fills a run of consecutive slots (see tools/hash_bench.cpp).
+ */
+struct XYHash {
+    unsigned int operator()(unsigned int key) const
+    {
+        key ^= key >> 16;
+        key *= 0x7feb352du;
+        key ^= key >> 15;
+        key *= 0x846ca68bu;
+        key ^= key >> 16;
+        return key;
+    }
+};
+
+/**
+ * the items of a sparse map, or the overlay of a mapped one, keyed by XY_KEY.
+ * the MapItem pointers are stored in the table's slots by value.
+ */
+typedef TypedHashTable<unsigned int, MapItem*, XYHash> ItemTable;
 
 /**
  * the Map structure.
- * this holds a HashTable for all the MapItems,
- * along with values for the width and height of the Map.
+ * this holds the storage for all the MapItems, either a hash table (sparse
+ * maps), a flat row-major grid of MapItem pointers (dense maps), a set of
+ * resident chunks (chunked maps) or a map file image (mapped maps), along
+ * with values for the width and height of the Map.
  */
 struct Map {
-    HashTable* items; // hashtables for all items of the map
+    int mode;         // MAP_DENSE, MAP_SPARSE, MAP_CHUNKED, MAP_MAPPED or MAP_UNLOADED
+    ItemTable* items; // hash table of all items of the map (MAP_SPARSE)
+    MapItem** tiles;  // w*h item pointers, NULL for empty cells (MAP_DENSE)
+    ChunkStore* chunked; // the resident chunks (MAP_CHUNKED)
+    MappedStore* mapped; // the attached map file image (MAP_MAPPED)
+    uint32_t* blocked;   // one bit per cell, set if its item blocks motion
+    uint32_t* hazards;   // one bit per cell, set if its item hurts the player
+    uint32_t* dirty;     // one bit per cell, set if it changed since last consumed
+    int compact_next;    // the next cell map_compact looks at
+    Arena* arena;        // everything above is allocated here, except hash tables
+    Portal* spare;       // freed portals, reused before the arena grows
+    Portal* live;        // the portals on the map
+    int storage;         // the storage map_create asked for
+    MapBuilder build;    // fills the map in when it is loaded, or NULL
+    void* context;       // passed to build
     int w, h;         // map dimensions
     int index;        // index of map (i.e., first map or second map)
 };
@@ -29,22 +86,31 @@ struct Map {
 // Important Definitions
 /////////////////////////////
 
-#define MHF_NBUCKETS 97     //  hashing value
-#define NUM_MAPS 3          //  number of total maps. can add more
-static Map maps[NUM_MAPS];  //  array of maps
-static int active_map;      //  current active map on screen
+#define MHF_NBUCKETS 97     //  initial number of hash table slots
+#define MAP_STATS_BINS 8    //  probe distance bins print_map_stats prints
+#define MIN_MAPS 4          //  initial room in the registry; it doubles as needed
 
+// the storage modes are in map.h. a map that was created but isn't loaded
+// (or was unloaded) has no storage, and no arena either.
+#define MAP_UNLOADED -1
 
-// to erase a MapItem, we can simply replace it
-// with a clear type item called clear sentinel
-static const MapItem CLEAR_SENTINEL = { 
-    .type = CLEAR,
-    .draw = draw_nothing
-};
+// the registry. maps are allocated one by one, so a Map* stays valid while
+// the array of pointers grows; a handle is an index into it.
+static Map** maps;          //  every map created, by handle
+static int num_maps;        //  number of maps created
+static int max_maps;        //  room in maps
+static int active_map;      //  current active map on screen
+
+// each map owns an arena that its grid, bitmaps, chunks and portal items are
+// carved from, so tearing a map down (to load or generate another level in
+// its place) is one arena reset instead of a free per item, and the heap
+// never sees the churn. every item that is not a portal is a shared
+// prototype (see below) and takes no memory at all.
+#define MAP_ARENA_BLOCK 512 //  size of each arena block; larger grids get their own
 
 
 /**
- * the first step in HashTable access for the map is turning the two-dimensional
+ * the first step in hash table access for the map is turning the two-dimensional
  * key information (x, y) into a one-dimensional unsigned integer.
  * this function should uniquely map (x,y) onto the space of unsigned integers.
  */
@@ -54,93 +120,811 @@ static unsigned XY_KEY(int X, int Y) {
 }
 
 /**
- * this is the hash function actually passed into createHashTable.
- * it takes an unsigned key (the output of XY_KEY) 
- * and turns it into a hash value.
+ * a portal MapItem together with the StairsData it points at, allocated from
+ * the arena of the map it is on.
  */
-unsigned map_hash(unsigned key)
+struct Portal {
+    MapItem item;
+    StairsData data;
+    Portal* prev;     // neighbors in the map's list of live portals; next
+    Portal* next;     // is also the next spare portal, while this one is unused
+};
+
+/**
+ * gives a portal MapItem back to its map, which reuses it for the next
+ * portal added. prototypes are never freed.
+ */
+static void free_item(Map* map, MapItem* item)
 {
-    // use MHF_NBUCKETS as the value to hash for your hash function
-    // return the hashed key
-    return key % MHF_NBUCKETS;
+    if (!item) return;
+    if (item->type == STAIRS || item->type == CAVE || item->type == SECRET_DOOR) {
+        // the item is the first member of its Portal
+        Portal* portal = (Portal*)item;
+        if (portal->prev) portal->prev->next = portal->next;
+        else map->live = portal->next;
+        if (portal->next) portal->next->prev = portal->prev;
+        portal->next = map->spare;
+        map->spare = portal;
+    }
 }
 
+
+/////////////////////////////////////////
+// Chunked Maps
+////////////////////////////////////////
+
 /**
- * initializes the map, using a hash_table, setting the width and height.
+ * one CHUNK_SIZE x CHUNK_SIZE block of a chunked map that is in memory.
+ * resident chunks are kept in a list from most to least recently used.
  */
-void maps_init()
+struct Chunk {
+    MapItem* tiles[CHUNK_SIZE * CHUNK_SIZE]; // row-major, NULL for empty cells
+    int cx, cy;       // chunk coordinates
+    int dirty;        // changed since it was loaded
+    int pinned;       // its loader is running, so it can't be evicted
+    Chunk* prev;      // more recently used neighbor
+    Chunk* next;      // less recently used neighbor
+};
+
+/**
+ * the storage of a chunked map.
+ */
+struct ChunkStore {
+    Chunk** chunks;   // cw*ch pointers, NULL while a chunk is not resident
+    int cw, ch;       // map dimensions in chunks
+    Chunk* head;      // most recently used resident chunk
+    Chunk* tail;      // least recently used resident chunk
+    int resident;     // number of resident chunks
+    int budget;       // resident chunks allowed before one is evicted
+    ChunkLoader load;
+    ChunkSaver save;
+    void* context;    // passed to load and save
+    unsigned loads, evictions;
+};
+
+/**
+ * takes a chunk out of the recently used list.
+ */
+static void lru_unlink(ChunkStore* store, Chunk* c)
+{
+    if (c->prev) c->prev->next = c->next;
+    else store->head = c->next;
+    if (c->next) c->next->prev = c->prev;
+    else store->tail = c->prev;
+}
+
+/**
+ * puts a chunk at the most recently used end of the list.
+ */
+static void lru_push_front(ChunkStore* store, Chunk* c)
+{
+    c->prev = NULL;
+    c->next = store->head;
+    if (store->head) store->head->prev = c;
+    else store->tail = c;
+    store->head = c;
+}
+
+/**
+ * evicts the least recently used chunk that may be evicted and returns its
+ * memory for reuse, or NULL if every resident chunk must stay. a changed
+ * chunk is only evicted if it can be saved first; otherwise its changes
+ * would be lost when it is loaded again.
+ */
+static Chunk* evict_chunk(Map* map)
+{
+    ChunkStore* store = map->chunked;
+    for (Chunk* c = store->tail; c; c = c->prev) {
+        if (c->pinned || (c->dirty && !store->save)) continue;
+        if (c->dirty) store->save(c->cx, c->cy, c->tiles, store->context);
+        for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++) free_item(map, c->tiles[i]);
+        store->chunks[c->cy * store->cw + c->cx] = NULL;
+        lru_unlink(store, c);
+        store->resident--;
+        store->evictions++;
+        return c;
+    }
+    return NULL;
+}
+
+/**
+ * returns resident chunk (cx,cy) of a chunked map, loading it first if needed.
+ */
+static Chunk* get_chunk(Map* map, int cx, int cy)
+{
+    ChunkStore* store = map->chunked;
+    Chunk* c = store->chunks[cy * store->cw + cx];
+    if (c) {
+        // most lookups hit the chunk used last; only move it when it isn't
+        if (c != store->head) {
+            lru_unlink(store, c);
+            lru_push_front(store, c);
+        }
+        return c;
+    }
+
+    // reuse the memory of an evicted chunk once the budget is used up
+    if (store->resident >= store->budget) c = evict_chunk(map);
+    if (!c) c = (Chunk*)arenaAlloc(map->arena, sizeof(Chunk));
+    memset(c->tiles, 0, sizeof(c->tiles));
+    c->cx = cx;
+    c->cy = cy;
+    c->dirty = 0;
+    c->pinned = 1;
+    store->chunks[cy * store->cw + cx] = c;
+    lru_push_front(store, c);
+    store->resident++;
+    store->loads++;
+    // the loader fills the chunk through the add_* functions
+    if (store->load) store->load(cx, cy, store->context);
+    c->pinned = 0;
+    return c;
+}
+
+/**
+ * returns a pointer to the cell (x,y) of a chunked map, or NULL if the
+ * location is outside the map. if the cell is about to be changed (modify),
+ * its chunk is marked dirty, unless this is the chunk's own loader at work.
+ */
+static MapItem** chunk_cell(Map* map, int x, int y, int modify)
+{
+    if (x < 0 || y < 0 || x >= map->w || y >= map->h) return NULL;
+    Chunk* c = get_chunk(map, x / CHUNK_SIZE, y / CHUNK_SIZE);
+    if (modify && !c->pinned) c->dirty = 1;
+    return &c->tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE];
+}
+
+
+/////////////////////////////////////////
+// Mapped Maps
+////////////////////////////////////////
+
+// defined with the prototypes further down
+static MapItem* tile(int kind);
+
+/**
+ * marks a cell of a mapped map whose tile in the image has been removed.
+ */
+static const MapItem TOMBSTONE = {CLEAR, draw_nothing, false, NULL};
+
+// who owns the image of a mapped map
+#define IMAGE_BORROWED 0    // the caller (an image in flash, for example)
+#define IMAGE_MALLOCED 1    // the map: read into the heap by map_load_file
+#define IMAGE_MMAPPED  2    // the map: mapped by map_load_file
+
+/**
+ * the storage of a mapped map. cells are indexed x + y * w, as in a dense map.
+ */
+struct MappedStore {
+    const unsigned char* image; // the whole map file
+    unsigned int size;          // its size in bytes
+    int owner;                  // IMAGE_BORROWED, IMAGE_MALLOCED or IMAGE_MMAPPED
+    const unsigned char* grid;  // its tile grid
+    ItemTable* overlay;         // portals and every change made since attaching
+    unsigned char* overlaid;    // one bit per cell, set if the overlay holds it
+};
+
+/**
+ * returns whether the overlay of a mapped map holds cell k. checking this
+ * bitmap first keeps most lookups from touching the overlay at all.
+ */
+static int is_overlaid(MappedStore* store, int k)
+{
+    return store->overlaid[k >> 3] & (1 << (k & 7));
+}
+
+/**
+ * returns the item in cell k of a mapped map, or NULL.
+ */
+static MapItem* mapped_lookup(Map* map, int k)
+{
+    MappedStore* store = map->mapped;
+    if (is_overlaid(store, k)) {
+        MapItem** item = store->overlay->get(k);
+        return (!item || *item == &TOMBSTONE) ? NULL : *item;
+    }
+    // portals always live in the overlay; an unknown kind reads as empty
+    int kind = store->grid[k];
+    return (kind < TILE_FIRST_PORTAL) ? tile(kind) : NULL;
+}
+
+/**
+ * stores item in cell k of a mapped map and returns the item it replaced.
+ */
+static MapItem* mapped_store(Map* map, int k, MapItem* item)
+{
+    MappedStore* store = map->mapped;
+    MapItem* old = mapped_lookup(map, k);
+    store->overlay->insert(k, item);
+    store->overlaid[k >> 3] |= 1 << (k & 7);
+    return old;
+}
+
+/**
+ * removes the item in cell k of a mapped map and returns it. a tile of the
+ * image is hidden with a tombstone; anything else just leaves the overlay.
+ * the overlay only ever holds portals, changes and tombstones, so it stays
+ * small; map_compact drops entries that have become redundant.
+ */
+static MapItem* mapped_remove(Map* map, int k)
+{
+    MappedStore* store = map->mapped;
+    MapItem* old = mapped_lookup(map, k);
+    if (!old) return NULL;
+    if (store->grid[k] < TILE_FIRST_PORTAL) {
+        store->overlay->insert(k, (MapItem*)&TOMBSTONE);
+        store->overlaid[k >> 3] |= 1 << (k & 7);
+    } else {
+        store->overlay->remove(k);
+        store->overlaid[k >> 3] &= ~(1 << (k & 7));
+    }
+    return old;
+}
+
+
+/////////////////////////////////////////
+// Walkability Bitmaps
+////////////////////////////////////////
+
+// every map but a chunked one keeps three bitmaps with one bit per cell, bit
+// x + y * w: whether the cell blocks motion, whether it hurts the player, and
+// whether it changed since the renderer last asked. map_store and map_remove
+// keep them in sync with the items, so collision checks read a bit instead of
+// looking up and dereferencing an item, runs and regions are checked 32 cells
+// at a time, and draw_game only repaints the tiles that changed.
+
+/**
+ * returns whether an item keeps the player from walking onto its cell.
+ * empty cells can be walked on.
+ */
+static int item_blocks(MapItem* item)
+{
+    return item && !item->walkable;
+}
+
+/**
+ * returns whether stepping onto an item hurts the player.
+ */
+static int item_hurts(MapItem* item)
+{
+    return item && (item->type == PEBBLE || item->type == HOLE);
+}
+
+/**
+ * allocates the (empty) bitmaps of a map whose width and height are set.
+ */
+static void alloc_bits(Map* map)
+{
+    int words = (map->w * map->h + 31) / 32;
+    map->blocked = (uint32_t*)arenaCalloc(map->arena, words, sizeof(uint32_t));
+    map->hazards = (uint32_t*)arenaCalloc(map->arena, words, sizeof(uint32_t));
+    map->dirty = (uint32_t*)arenaCalloc(map->arena, words, sizeof(uint32_t));
+}
+
+static int get_bit(const uint32_t* bits, int k)
+{
+    return (bits[k >> 5] >> (k & 31)) & 1;
+}
+
+static void set_bit(uint32_t* bits, int k, int on)
+{
+    if (on) bits[k >> 5] |= 1u << (k & 31);
+    else bits[k >> 5] &= ~(1u << (k & 31));
+}
+
+/**
+ * records the item now in cell k of a map in its bitmaps.
+ */
+static void update_bits(Map* map, int k, MapItem* item)
+{
+    if (!map->blocked || k < 0) return;
+    set_bit(map->blocked, k, item_blocks(item));
+    set_bit(map->hazards, k, item_hurts(item));
+    set_bit(map->dirty, k, 1);
+}
+
+/**
+ * returns the bits [k, k+n) of a bitmap as the low bits of a word; n <= 32
+ * and the bits may straddle two words.
+ */
+static uint32_t get_bits(const uint32_t* bits, int k, int n)
+{
+    uint32_t word = bits[k >> 5] >> (k & 31);
+    if ((k & 31) + n > 32) word |= bits[(k >> 5) + 1] << (32 - (k & 31));
+    return (n < 32) ? word & ((1u << n) - 1) : word;
+}
+
+static int popcount(uint32_t word)
 {
-    // loop through all possible maps, where for each map's items, create a hashtable
-    for (int i = 0; i < NUM_MAPS; i++) {
-        maps[i].items = createHashTable(map_hash, MHF_NBUCKETS);
-        // set width & height for any maps
-        // main map is 50x50
-        if (i == 0) {
-            maps[i].index = 0;
-            maps[i].h = 50;
-            maps[i].w = 50;
+    word = word - ((word >> 1) & 0x55555555u);
+    word = (word & 0x33333333u) + ((word >> 2) & 0x33333333u);
+    return (((word + (word >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+/**
+ * returns the number of set bits in [k, k+n).
+ */
+static int count_bits(const uint32_t* bits, int k, int n)
+{
+    int count = 0;
+    for (int i = 0; i < n; i += 32) {
+        count += popcount(get_bits(bits, k + i, (n - i < 32) ? n - i : 32));
+    }
+    return count;
+}
+
+/**
+ * returns the offset from k of the first set bit in [k, k+n), or n.
+ */
+static int first_bit(const uint32_t* bits, int k, int n)
+{
+    for (int i = 0; i < n; i += 32) {
+        uint32_t word = get_bits(bits, k + i, (n - i < 32) ? n - i : 32);
+        if (word) {
+            int j = 0;
+            while (!(word & 1)) { word >>= 1; j++; }
+            return i + j;
+        }
+    }
+    return n;
+}
+
+/**
+ * returns the offset from k of the last set bit in [k, k+n), or -1.
+ */
+static int last_bit(const uint32_t* bits, int k, int n)
+{
+    for (int end = n; end > 0; end -= 32) {
+        int len = (end < 32) ? end : 32;
+        uint32_t word = get_bits(bits, k + end - len, len);
+        if (word) {
+            int j = len - 1;
+            while (!(word >> j)) j--;
+            return end - len + j;
         }
-        // smaller map is 16x16
-        else if (i == 1) {
-            maps[i].index = 1;
-            maps[i].h = 16;
-            maps[i].w = 16;
+    }
+    return -1;
+}
+
+
+/////////////////////////////////////////
+// Map Storage
+////////////////////////////////////////
+
+// every access to the items of a map goes through these three functions, so
+// the rest of this file does not care how the map is stored.
+
+/**
+ * returns the index of (x,y) in a dense map's grid, or -1 if the location is
+ * outside it. like XY_KEY, a location just off the left or right edge wraps
+ * onto the neighboring row.
+ */
+static int dense_index(Map* map, int x, int y)
+{
+    int k = x + y * map->w;
+    return (k >= 0 && k < map->w * map->h) ? k : -1;
+}
+
+/**
+ * returns a pointer to the cell (x,y) of a dense or chunked map, or NULL if
+ * the location is outside the map.
+ */
+static MapItem** map_cell(Map* map, int x, int y, int modify)
+{
+    if (map->mode == MAP_CHUNKED) return chunk_cell(map, x, y, modify);
+    int k = dense_index(map, x, y);
+    return (k >= 0) ? &map->tiles[k] : NULL;
+}
+
+/**
+ * returns the item stored at (x,y) on the active map, or NULL.
+ */
+static MapItem* map_lookup(int x, int y)
+{
+    Map* map = get_active_map();
+    if (map->mode == MAP_SPARSE) {
+        MapItem** item = map->items->get(XY_KEY(x, y));
+        return item ? *item : NULL;
+    }
+    if (map->mode == MAP_MAPPED) {
+        int k = dense_index(map, x, y);
+        return (k >= 0) ? mapped_lookup(map, k) : NULL;
+    }
+    MapItem** cell = map_cell(map, x, y, false);
+    return cell ? *cell : NULL;
+}
+
+/**
+ * stores item at (x,y) on the active map and returns the item it replaced
+ * (or NULL). only a sparse map can store anything outside its bounds:
+ * the others return the item itself instead.
+ */
+static MapItem* map_store(int x, int y, MapItem* item)
+{
+    Map* map = get_active_map();
+    update_bits(map, dense_index(map, x, y), item);
+    if (map->mode == MAP_SPARSE) {
+        MapItem* old;
+        return map->items->insert(XY_KEY(x, y), item, &old) ? old : NULL;
+    }
+    if (map->mode == MAP_MAPPED) {
+        int k = dense_index(map, x, y);
+        return (k >= 0) ? mapped_store(map, k, item) : item;
+    }
+    MapItem** cell = map_cell(map, x, y, true);
+    if (!cell) return item;
+    MapItem* old = *cell;
+    *cell = item;
+    return old;
+}
+
+/**
+ * removes the item stored at (x,y) on the active map and returns it (or NULL).
+ */
+static MapItem* map_remove(int x, int y)
+{
+    Map* map = get_active_map();
+    update_bits(map, dense_index(map, x, y), NULL);
+    if (map->mode == MAP_SPARSE) {
+        MapItem* old;
+        return map->items->remove(XY_KEY(x, y), &old) ? old : NULL;
+    }
+    if (map->mode == MAP_MAPPED) {
+        int k = dense_index(map, x, y);
+        return (k >= 0) ? mapped_remove(map, k) : NULL;
+    }
+    MapItem** cell = map_cell(map, x, y, true);
+    if (!cell) return NULL;
+    MapItem* old = *cell;
+    *cell = NULL;
+    return old;
+}
+
+/**
+ * frees everything a map stores, and the storage itself, leaving the map
+ * unloaded. the hash tables don't own their items (the arena does), so
+ * destroying one frees its few arrays without visiting its entries;
+ * everything else goes with the arena. a map that had no arena is given
+ * one, for whatever storage replaces this.
+ */
+static void release_storage(Map* map)
+{
+    if (map->mode == MAP_SPARSE) {
+        delete map->items;
+    } else if (map->mode == MAP_MAPPED) {
+        MappedStore* store = map->mapped;
+        delete store->overlay;
+        if (store->owner == IMAGE_MALLOCED) free((void*)store->image);
+#ifdef HAVE_MMAP
+        if (store->owner == IMAGE_MMAPPED) munmap((void*)store->image, store->size);
+#endif
+    }
+    if (map->arena) arenaReset(map->arena);
+    else map->arena = createArena(MAP_ARENA_BLOCK);
+    map->mode = MAP_UNLOADED;
+    map->spare = NULL;
+    map->live = NULL;
+    map->items = NULL;
+    map->tiles = NULL;
+    map->chunked = NULL;
+    map->mapped = NULL;
+    map->blocked = NULL;
+    map->hazards = NULL;
+    map->dirty = NULL;
+}
+
+/**
+ * gives a map whose width and height are set empty MAP_DENSE or MAP_SPARSE
+ * storage.
+ */
+static void init_grid(Map* map, int mode)
+{
+    int area = map->w * map->h;
+    alloc_bits(map);
+    map->mode = mode;
+    if (mode == MAP_DENSE) {
+        // a grid with one (initially empty) cell per location
+        map->tiles = (MapItem**)arenaCalloc(map->arena, area, sizeof(MapItem*));
+    } else {
+        // flat Robin Hood storage: lookups scan contiguous slots instead of
+        // chasing one heap node per tile, and the table grows as items are added
+        map->items = new ItemTable(MHF_NBUCKETS);
+    }
+}
+
+/**
+ * gives an unloaded map the storage map_create asked for and runs its
+ * builder, with the map active.
+ */
+static void load_map(Map* map)
+{
+    release_storage(map);
+    if (map->storage == MAP_DENSE || map->storage == MAP_SPARSE) init_grid(map, map->storage);
+    active_map = map->index;
+    if (map->build) map->build(map->index, map->context);
+    // a builder that should have attached an image or set up chunks but
+    // couldn't leaves the map empty rather than unusable
+    if (map->mode == MAP_UNLOADED) init_grid(map, MAP_SPARSE);
+}
+
+/**
+ * returns whether a portal on a loaded map other than map m takes the player
+ * to map m.
+ */
+static int is_referenced(int m)
+{
+    for (int i = 0; i < num_maps; i++) {
+        if (i == m) continue;
+        for (Portal* p = maps[i]->live; p; p = p->next) {
+            if (p->data.tm == m) return true;
         }
-        // secret map is 12x12
-        else {
-            maps[i].index = 2;
-            maps[i].h = 12;
-            maps[i].w = 12;
+    }
+    return false;
+}
+
+/**
+ * initializes the map registry. no map exists until map_create adds it.
+ */
+void maps_init()
+{
+    num_maps = 0;
+    max_maps = MIN_MAPS;
+    maps = (Map**)malloc(max_maps * sizeof(Map*));
+    active_map = 0;
+}
+
+int map_create(int w, int h, int storage, MapBuilder build, void* context)
+{
+    if (num_maps == max_maps) {
+        max_maps *= 2;
+        maps = (Map**)realloc(maps, max_maps * sizeof(Map*));
+    }
+    // only the description is kept for now; the storage comes when the map
+    // is first made active
+    Map* map = (Map*)malloc(sizeof(Map));
+    map->mode = MAP_UNLOADED;
+    map->items = NULL;
+    map->tiles = NULL;
+    map->chunked = NULL;
+    map->mapped = NULL;
+    map->blocked = NULL;
+    map->hazards = NULL;
+    map->dirty = NULL;
+    map->compact_next = 0;
+    map->arena = NULL;
+    map->spare = NULL;
+    map->live = NULL;
+    map->storage = storage;
+    map->build = build;
+    map->context = context;
+    map->w = w;
+    map->h = h;
+    map->index = num_maps;
+    maps[num_maps] = map;
+    return num_maps++;
+}
+
+int map_count()
+{
+    return num_maps;
+}
+
+int map_unload(int m)
+{
+    Map* map = maps[m];
+    if (map->mode == MAP_UNLOADED) return true;
+    if (m == active_map || is_referenced(m)) return false;
+    // changed chunks are saved, just as if they were being evicted
+    if (map->mode == MAP_CHUNKED) {
+        ChunkStore* store = map->chunked;
+        for (Chunk* c = store->head; c; c = c->next) {
+            if (c->dirty && store->save) store->save(c->cx, c->cy, c->tiles, store->context);
         }
-        // set the first map to be active
-        if (i == 0) active_map = i;
     }
+    release_storage(map);
+    destroyArena(map->arena);
+    map->arena = NULL;
+    return true;
 }
 
+void map_clear(int m)
+{
+    Map* map = maps[m];
+    if (map->mode == MAP_UNLOADED) return;
+    if (map->mode == MAP_CHUNKED) {
+        ChunkStore* store = map->chunked;
+        map_init_chunked(m, map->w, map->h, store->budget, store->load, store->save,
+                         store->context);
+        return;
+    }
+    // a sparse map stays sparse; a dense or mapped one was full of tiles, so
+    // it is expected to be filled again
+    int mode = (map->mode == MAP_SPARSE) ? MAP_SPARSE : MAP_DENSE;
+    release_storage(map);
+    init_grid(map, mode);
+}
+
+void map_init_chunked(int m, int w, int h, int budget, ChunkLoader load, ChunkSaver save,
+                      void* context)
+{
+    Map* map = maps[m];
+    release_storage(map);
+
+    ChunkStore* store = (ChunkStore*)arenaAlloc(map->arena, sizeof(ChunkStore));
+    store->cw = (w + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    store->ch = (h + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    store->chunks = (Chunk**)arenaCalloc(map->arena, store->cw * store->ch, sizeof(Chunk*));
+    store->head = NULL;
+    store->tail = NULL;
+    store->resident = 0;
+    store->budget = (budget > 0) ? budget : 1;
+    store->load = load;
+    store->save = save;
+    store->context = context;
+    store->loads = 0;
+    store->evictions = 0;
+
+    map->mode = MAP_CHUNKED;
+    map->chunked = store;
+    map->w = w;
+    map->h = h;
+}
 
 Map* get_active_map()
 {
     // return a pointer to the current map based on which map is active (active_map)
-    return &maps[active_map];
+    return maps[active_map];
 }
 
 int get_active_map_index()
 {
     // return the index to the current map based on which map is active (active_map)
-    return maps[active_map].index;
+    return maps[active_map]->index;
+}
+
+Map* get_map(int m)
+{
+    return maps[m];
 }
 
 Map* set_active_map(int m)
 {
+    // a map is only loaded the first time it is made active
+    if (maps[m]->mode == MAP_UNLOADED) load_map(maps[m]);
     // set the global variable for active map to the map index passed in
     active_map = m;
-    // update the index for the active map to the index passed in
-    maps[active_map].index = m;
     // return a pointer to the current map based on which map is active (active_map)
-    return &maps[active_map];
+    return maps[active_map];
+}
+
+void map_for_each(MapItemVisitor visit, void* context)
+{
+    Map* map = get_active_map();
+    if (map->mode == MAP_DENSE) {
+        for (int k = 0; k < map->w * map->h; k++) {
+            MapItem* item = map->tiles[k];
+            if (item) visit(k % map->w, k / map->w, item, context);
+        }
+        return;
+    }
+    if (map->mode == MAP_MAPPED) {
+        for (int k = 0; k < map->w * map->h; k++) {
+            MapItem* item = mapped_lookup(map, k);
+            if (item) visit(k % map->w, k / map->w, item, context);
+        }
+        return;
+    }
+    // only the resident chunks of a chunked map are visited
+    if (map->mode == MAP_CHUNKED) {
+        ChunkStore* store = map->chunked;
+        for (int k = 0; k < store->cw * store->ch; k++) {
+            Chunk* c = store->chunks[k];
+            for (int i = 0; c && i < CHUNK_SIZE * CHUNK_SIZE; i++) {
+                MapItem* item = c->tiles[i];
+                if (!item) continue;
+                visit(c->cx * CHUNK_SIZE + i % CHUNK_SIZE, c->cy * CHUNK_SIZE + i / CHUNK_SIZE,
+                      item, context);
+            }
+        }
+        return;
+    }
+    // turn each (key, item) pair of the hash table back into (x, y, item)
+    ItemTable::Cursor cursor;
+    unsigned key;
+    MapItem* item;
+    map->items->begin(cursor);
+    while (map->items->next(cursor, &key, &item)) {
+        int x = key % map->w;
+        int y = key / map->w;
+        // skip anything stored outside the map
+        if (y >= map->h) continue;
+        visit(x, y, item, context);
+    }
+}
+
+/**
+ * puts the print_map character of an item into the character grid.
+ */
+static void print_map_visit(int x, int y, MapItem* item, void* context)
+{
+    // NOTE: As you add more types, you'll need to add more items to this array.
+    static const char lookup[] = {'W', 'D', 'P', 'A', 'K', 'C', 'N', ' ', 'S', 'V',
+                                  'M', 'F', 'R', 'E', 'B', 'b', '.', '+', 'G', 'U',
+                                  'O', '#', 'm'};
+    char* grid = (char*)context;
+    int type = item->type;
+    grid[y * map_width() + x] = (type >= 0 && type < (int)sizeof(lookup)) ? lookup[type] : '?';
 }
 
 /**
  *  prints out the map for debugging on the terminal
+ *  only the stored items are visited; empty cells stay blank.
  */
 
 void print_map()
 {
-    // NOTE: As you add more types, you'll need to add more items to this array.
-    char lookup[] = {'W', 'D', 'P', 'A', 'K', 'C', 'N',' ','S'};
     Map* map = get_active_map();
+    char* grid = (char*)malloc(map->w * map->h);
+    memset(grid, ' ', map->w * map->h);
+    map_for_each(print_map_visit, grid);
     for(int j = 0; j < map->h; j++)
     {
         for (int i = 0; i < map->w; i++)
         {
-            MapItem* item = (MapItem*)getItem(map->items, XY_KEY(i, j));
-            if (item) pc.printf("%c", lookup[item->type]);
-            else pc.printf(" ");
+            pc.printf("%c", grid[j * map->w + i]);
         }
         pc.printf("\r\n");
     }
+    free(grid);
 }
 
+/**
+ * prints the hash table statistics of the active map
+ */
+void print_map_stats()
+{
+    Map* map = get_active_map();
+    unsigned histogram[MAP_STATS_BINS];
+    ArenaStats arena;
+    getArenaStats(map->arena, &arena);
+    pc.printf("map %d: arena %u/%u bytes in %u blocks (peak %u)\r\n", map->index,
+              arena.used, arena.capacity, arena.blocks, arena.peak);
+    // a dense map has no hash table; its grid is all there is to report
+    if (map->mode == MAP_DENSE) {
+        int n = 0;
+        for (int k = 0; k < map->w * map->h; k++) n += (map->tiles[k] != NULL);
+        pc.printf("map %d: dense %dx%d grid, %d items\r\n", map->index, map->w, map->h, n);
+        return;
+    }
+    if (map->mode == MAP_MAPPED) {
+        MappedStore* store = map->mapped;
+        pc.printf("map %d: mapped %dx%d image (%u bytes), %u overlay items\r\n",
+                  map->index, map->w, map->h, store->size, store->overlay->size());
+        return;
+    }
+    if (map->mode == MAP_CHUNKED) {
+        ChunkStore* store = map->chunked;
+        pc.printf("map %d: chunked %dx%d, %d/%d chunks resident, %u loads, %u evictions\r\n",
+                  map->index, map->w, map->h, store->resident, store->budget,
+                  store->loads, store->evictions);
+        return;
+    }
+    // the same report printHashTableStats gives a HT_ROBIN_HOOD table
+    ItemTable* items = map->items;
+    pc.printf("map %d: %u items, %u slots, load %.2f\r\n", map->index, items->size(),
+              items->numSlots(), items->loadFactor());
+#ifdef HT_STATS
+    const ItemTable::Stats& stats = items->stats();
+    pc.printf("  lookups %u (hits %u, misses %u), probes %u, %.2f per lookup\r\n",
+              stats.lookups, stats.hits, stats.misses, stats.probes,
+              stats.lookups ? (float)stats.probes / (float)stats.lookups : 0.0f);
+#endif
+    unsigned longest = items->histogram(histogram, MAP_STATS_BINS);
+    pc.printf("  probe distance (longest %u):\r\n", longest);
+    for (unsigned i = 0; i < MAP_STATS_BINS; i++) {
+        pc.printf("    %u%s: %u\r\n", i, i + 1 == MAP_STATS_BINS ? "+" : "", histogram[i]);
+    }
+}
 
 /**
  * returns width of active map
@@ -186,15 +970,7 @@ int map_area()
  */
 MapItem* get_north(int x, int y)
 {
-    // get map item
-    HashTable *ht = maps[get_active_map_index()].items;
-    MapItem *item = (MapItem*)getItem(ht, XY_KEY(x, y-1));
-    // if the item exist and is a clear type, remove item
-    if (item != NULL && item->type == CLEAR) {
-        removeItem(ht, XY_KEY(x, y-1));
-    }
-    // return the item;
-    return item;
+    return map_lookup(x, y-1);
 }
 
 /**
@@ -202,15 +978,7 @@ MapItem* get_north(int x, int y)
  */
 MapItem* get_south(int x, int y)
 {
-    // get map item
-    HashTable *ht = maps[get_active_map_index()].items;
-    MapItem *item = (MapItem*)getItem(ht, XY_KEY(x, y+1));
-    // if the item exist and is a clear type, remove item
-    if (item != NULL && item->type == CLEAR) {
-        removeItem(ht, XY_KEY(x, y+1));
-    }
-    // return the item
-    return item;
+    return map_lookup(x, y+1);
 }
 
 /**
@@ -218,15 +986,7 @@ MapItem* get_south(int x, int y)
  */
 MapItem* get_east(int x, int y)
 {
-    // get map item
-    HashTable *ht = maps[get_active_map_index()].items;
-    MapItem *item = (MapItem*)getItem(ht, XY_KEY(x+1, y));
-    // if the item exist and is a clear type, remove item
-    if (item != NULL && item->type == CLEAR) {
-        removeItem(ht, XY_KEY(x+1, y));
-    }
-    // return the item
-    return item;
+    return map_lookup(x+1, y);
 }
 
 /**
@@ -234,42 +994,350 @@ MapItem* get_east(int x, int y)
  */
 MapItem* get_west(int x, int y)
 {
-    // get map item
-    HashTable *ht = maps[get_active_map_index()].items;
-    MapItem *item = (MapItem*)getItem(ht, XY_KEY(x-1, y));
-    // if the item exist and is a clear type, remove item
-    if (item != NULL && item->type == CLEAR) {
-        removeItem(ht, XY_KEY(x-1, y));
-        // return item;
-    }
-    // return the item
-    return item;
+    return map_lookup(x-1, y);
 }
 
 /**
  * returns the MapItem at current coordinate location
  */
- MapItem* get_here(int x, int y)
- {
-    // get map item 
-    HashTable *ht = maps[get_active_map_index()].items;
-    MapItem *item = (MapItem*)getItem(ht, XY_KEY(x, y));
-    // if the item exist and is a clear type, remove item
-    if (item != NULL && item->type == CLEAR) {
-        removeItem(ht, XY_KEY(x, y));
-    }
-    // return the item
-    return item;
- }
+MapItem* get_here(int x, int y)
+{
+    return map_lookup(x, y);
+}
  
 
 /**
- * erases item on a location by replacing it with a clear sentinel
+ * looks up a batch of locations on the active map with batched hash table lookups.
+ */
+void get_items(int n, const int* xs, const int* ys, MapItem** items)
+{
+    // a batch is resolved in chunks of this many keys
+    const int CHUNK = 32;
+    unsigned keys[CHUNK];
+    MapItem** found[CHUNK];
+    ItemTable *ht = get_active_map()->items;
+    int w = map_width();
+    int h = map_height();
+
+    // a dense or chunked map needs no batching: every lookup is an array index
+    if (get_active_map()->mode != MAP_SPARSE) {
+        for (int i = 0; i < n; i++) {
+            int x = xs[i];
+            int y = ys[i];
+            // locations outside the map have no item
+            items[i] = (x < 0 || y < 0 || x >= w || y >= h) ? NULL : map_lookup(x, y);
+        }
+        return;
+    }
+
+    for (int base = 0; base < n; base += CHUNK) {
+        int m = (n - base < CHUNK) ? n - base : CHUNK;
+        for (int i = 0; i < m; i++) {
+            keys[i] = XY_KEY(xs[base + i], ys[base + i]);
+        }
+        ht->getMany(keys, found, m);
+        for (int i = 0; i < m; i++) {
+            int x = xs[base + i];
+            int y = ys[base + i];
+            // locations outside the map have no item
+            if (x < 0 || y < 0 || x >= w || y >= h || !found[i]) {
+                items[base + i] = NULL;
+            } else {
+                items[base + i] = *found[i];
+            }
+        }
+    }
+}
+
+/**
+ * copies the n items starting at (x,y) on one row of a map into out. the
+ * whole run must be inside the map.
+ */
+static void read_row(Map* map, int x, int y, int n, MapItem** out)
+{
+    if (map->mode == MAP_DENSE) {
+        // a row of the grid is already an array of item pointers
+        memcpy(out, &map->tiles[x + y * map->w], n * sizeof(MapItem*));
+    } else if (map->mode == MAP_MAPPED) {
+        int k = x + y * map->w;
+        for (int i = 0; i < n; i++) out[i] = mapped_lookup(map, k + i);
+    } else if (map->mode == MAP_CHUNKED) {
+        // copy the run one chunk at a time
+        for (int i = 0; i < n; ) {
+            int cx = (x + i) % CHUNK_SIZE;
+            int m = (CHUNK_SIZE - cx < n - i) ? CHUNK_SIZE - cx : n - i;
+            Chunk* c = get_chunk(map, (x + i) / CHUNK_SIZE, y / CHUNK_SIZE);
+            memcpy(out + i, &c->tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + cx], m * sizeof(MapItem*));
+            i += m;
+        }
+    } else {
+        // look the row up in batches, as get_items does
+        const int CHUNK = 32;
+        unsigned keys[CHUNK];
+        MapItem** found[CHUNK];
+        for (int base = 0; base < n; base += CHUNK) {
+            int m = (n - base < CHUNK) ? n - base : CHUNK;
+            for (int i = 0; i < m; i++) keys[i] = XY_KEY(x + base + i, y);
+            map->items->getMany(keys, found, m);
+            for (int i = 0; i < m; i++) out[base + i] = found[i] ? *found[i] : NULL;
+        }
+    }
+}
+
+/**
+ * reads a rectangular region of the active map row by row.
+ */
+void get_region(int x, int y, int w, int h, MapItem** items)
+{
+    Map* map = get_active_map();
+    // the columns [lo, hi) of the region are inside the map
+    int lo = (x < 0) ? -x : 0;
+    int hi = (x + w > map->w) ? map->w - x : w;
+
+    for (int j = 0; j < h; j++) {
+        MapItem** row = items + j * w;
+        // locations outside the map have no item
+        if (y + j < 0 || y + j >= map->h || lo >= hi) {
+            for (int i = 0; i < w; i++) row[i] = NULL;
+            continue;
+        }
+        for (int i = 0; i < lo; i++) row[i] = NULL;
+        for (int i = hi; i < w; i++) row[i] = NULL;
+        read_row(map, x + lo, y + j, hi - lo, row + lo);
+    }
+}
+
+/**
+ * reads the square around (x,y) as one region.
+ */
+void get_neighborhood(int x, int y, int radius, MapItem** items)
+{
+    get_region(x - radius, y - radius, 2 * radius + 1, 2 * radius + 1, items);
+}
+
+/**
+ * walks a ray across the active map, stopping at the first blocking tile.
+ * east and west rays are a scan of the blocked bitmap, 32 cells at a time.
+ */
+int map_ray(int x, int y, int dir, int n)
+{
+    static const int DX[4] = {0, 0, 1, -1};
+    static const int DY[4] = {-1, 1, 0, 0};
+    Map* map = get_active_map();
+    int inside = x >= 0 && y >= 0 && x < map->w && y < map->h;
+    if (map->blocked && inside && dir == DIR_EAST) {
+        // cells past the end of the row are off the map
+        int m = (n < map->w - 1 - x) ? n : map->w - 1 - x;
+        return first_bit(map->blocked, x + y * map->w + 1, m);
+    }
+    if (map->blocked && inside && dir == DIR_WEST) {
+        int m = (n < x) ? n : x;
+        return m - 1 - last_bit(map->blocked, x + y * map->w - m, m);
+    }
+    for (int k = 1; k <= n; k++) {
+        int tx = x + DX[dir] * k;
+        int ty = y + DY[dir] * k;
+        if (tx < 0 || ty < 0 || tx >= map->w || ty >= map->h) return k - 1;
+        if (map->blocked ? get_bit(map->blocked, tx + ty * map->w)
+                         : item_blocks(map_lookup(tx, ty))) {
+            return k - 1;
+        }
+    }
+    return n;
+}
+
+int map_walkable(int x, int y)
+{
+    Map* map = get_active_map();
+    if (x < 0 || y < 0 || x >= map->w || y >= map->h) return false;
+    if (!map->blocked) return !item_blocks(map_lookup(x, y));
+    return !get_bit(map->blocked, x + y * map->w);
+}
+
+int map_hazard(int x, int y)
+{
+    Map* map = get_active_map();
+    if (x < 0 || y < 0 || x >= map->w || y >= map->h) return false;
+    if (!map->hazards) return item_hurts(map_lookup(x, y));
+    return get_bit(map->hazards, x + y * map->w);
+}
+
+/**
+ * counts the cells of a region of the active map that are set in bits (or,
+ * for a map without bitmaps, that test says yes to). cells outside the map
+ * count as outside says.
+ */
+static int count_region(uint32_t* bits, int (*test)(MapItem*), int outside,
+                        int x, int y, int w, int h)
+{
+    Map* map = get_active_map();
+    if (w <= 0 || h <= 0) return 0;
+    // clip the region to the map
+    int x0 = (x < 0) ? 0 : x;
+    int y0 = (y < 0) ? 0 : y;
+    int x1 = (x + w > map->w) ? map->w : x + w;
+    int y1 = (y + h > map->h) ? map->h : y + h;
+    int count = 0, inside = 0;
+    if (x0 < x1 && y0 < y1) {
+        inside = (x1 - x0) * (y1 - y0);
+        for (int j = y0; j < y1; j++) {
+            if (bits) {
+                count += count_bits(bits, x0 + j * map->w, x1 - x0);
+            } else {
+                for (int i = x0; i < x1; i++) count += test(map_lookup(i, j));
+            }
+        }
+    }
+    return count + (outside ? w * h - inside : 0);
+}
+
+int map_count_blocked(int x, int y, int w, int h)
+{
+    return count_region(get_active_map()->blocked, item_blocks, true, x, y, w, h);
+}
+
+int map_count_hazards(int x, int y, int w, int h)
+{
+    return count_region(get_active_map()->hazards, item_hurts, false, x, y, w, h);
+}
+
+/**
+ * reads and clears the dirty bits of a region of the active map.
+ */
+int map_consume_dirty(int x, int y, int w, int h, unsigned char* changed)
+{
+    Map* map = get_active_map();
+    int count = 0;
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            int tx = x + i;
+            int ty = y + j;
+            int on = 0;
+            if (tx >= 0 && ty >= 0 && tx < map->w && ty < map->h) {
+                // a chunked map doesn't track changes, so anything may have changed
+                int k = tx + ty * map->w;
+                on = map->dirty ? get_bit(map->dirty, k) : 1;
+                if (on && map->dirty) set_bit(map->dirty, k, 0);
+            }
+            if (changed) changed[j * w + i] = on;
+            count += on;
+        }
+    }
+    return count;
+}
+
+/**
+ * drops the overlay entries of a mapped map that put back the very tile its
+ * image already holds (a tile that was erased and then added again, say).
+ */
+int map_compact(int n)
+{
+    Map* map = get_active_map();
+    if (map->mode != MAP_MAPPED) return 0;
+    MappedStore* store = map->mapped;
+    int area = map->w * map->h;
+    int dropped = 0;
+    for (int i = 0; i < n && i < area; i++) {
+        int k = map->compact_next;
+        map->compact_next = (k + 1 < area) ? k + 1 : 0;
+        if (!is_overlaid(store, k)) continue;
+        int kind = store->grid[k];
+        MapItem** item = store->overlay->get(k);
+        if (kind < TILE_FIRST_PORTAL && item && *item == tile(kind)) {
+            // the item is a shared prototype, so there is nothing to free
+            store->overlay->remove(k);
+            store->overlaid[k >> 3] &= ~(1 << (k & 7));
+            dropped++;
+        }
+    }
+    return dropped;
+}
+
+/**
+ * erases the item on a location. the cell is marked changed, which is how
+ * draw_game learns to blank it.
  */
 void map_erase(int x, int y)
 {
-    MapItem* item = (MapItem*)insertItem(get_active_map()->items, XY_KEY(x, y), (void*)&CLEAR_SENTINEL);
-    if(item) free(item);
+    free_item(get_active_map(), map_remove(x, y));
+}
+
+
+/////////////////////////////////////////
+// Allocating Map Items
+////////////////////////////////////////
+
+/**
+ * one immutable prototype MapItem per tile kind (see map_format.h). every
+ * tile of a kind without per-tile data points at its prototype, so adding or
+ * replacing one allocates and frees nothing. portal prototypes are only
+ * copied from.
+ */
+static const MapItem PROTOTYPES[NUM_TILE_KINDS] = {
+    /* TILE_WALL          */ {WALL,          draw_wall,             false, NULL},
+    /* TILE_DOOR          */ {DOOR,          draw_door,             false, NULL},
+    /* TILE_PLANT         */ {PLANT,         draw_plant,            true,  NULL},
+    /* TILE_WATER         */ {WATER,         draw_water,            true,  NULL},
+    /* TILE_NPC           */ {NPC,           draw_npc,              false, NULL},
+    /* TILE_MUD           */ {MUD,           draw_mud,              true,  NULL},
+    /* TILE_FIRE          */ {FIRE,          draw_fire,             true,  NULL},
+    /* TILE_WRECK         */ {RAMBLIN_WRECK, draw_wreck,            false, NULL},
+    /* TILE_EARTH         */ {EARTH,         draw_earth,            true,  NULL},
+    /* TILE_BUZZ          */ {BUZZ,          draw_buzz,             false, NULL},
+    /* TILE_SLAIN_BUZZ    */ {SLAIN_BUZZ,    draw_slain_buzz,       false, NULL},
+    /* TILE_PEBBLE        */ {PEBBLE,        draw_pebble,           true,  NULL},
+    /* TILE_POWER_UP      */ {POWER_UP,      draw_power_up,         true,  NULL},
+    /* TILE_GIFT_BOX      */ {GIFT_BOX,      draw_gift_box,         false, NULL},
+    /* TILE_BUSH          */ {BUSH,          draw_bush,             true,  NULL},
+    /* TILE_HOLE          */ {HOLE,          draw_hole,             true,  NULL},
+    /* TILE_MUSHROOM      */ {MUSHROOM,      draw_mushroom,         true,  NULL},
+    /* TILE_STAIRS        */ {STAIRS,        draw_stairs,           true,  NULL},
+    /* TILE_SECRET_STAIRS */ {STAIRS,        draw_secret_stairs,    true,  NULL},
+    /* TILE_SECRET_DOOR   */ {SECRET_DOOR,   draw_secret_entrance,  true,  NULL},
+    /* TILE_CAVE1         */ {CAVE,          draw_cave1,            true,  NULL},
+    /* TILE_CAVE2         */ {CAVE,          draw_cave2,            true,  NULL},
+    /* TILE_CAVE3         */ {CAVE,          draw_cave3,            true,  NULL},
+    /* TILE_CAVE4         */ {CAVE,          draw_cave4,            true,  NULL},
+};
+
+/**
+ * returns the shared prototype of a tile kind.
+ */
+static MapItem* tile(int kind)
+{
+    return (MapItem*)&PROTOTYPES[kind];
+}
+
+/**
+ * makes a portal MapItem for map, a copy of its prototype with its own
+ * StairsData taking the player to (tx,ty) on map tm. a spare portal of the
+ * map is reused if there is one; otherwise it comes from the map's arena.
+ */
+static MapItem* new_portal(Map* map, int kind, int tm, int tx, int ty)
+{
+    Portal* portal = map->spare;
+    if (portal) map->spare = portal->next;
+    else portal = (Portal*)arenaAlloc(map->arena, sizeof(Portal));
+    portal->item = PROTOTYPES[kind];
+    portal->item.data = &portal->data;
+    portal->data.tm = tm;
+    portal->data.tx = tx;
+    portal->data.ty = ty;
+    portal->prev = NULL;
+    portal->next = map->live;
+    if (map->live) map->live->prev = portal;
+    map->live = portal;
+    return &portal->item;
+}
+
+/**
+ * stores an item at (x,y) on the active map.
+ * if something is already there (or the map can't hold the item), it is
+ * given back to the map.
+ */
+static void place_item(int x, int y, MapItem* item)
+{
+    free_item(get_active_map(), map_store(x, y, item));
 }
 
 
@@ -279,147 +1347,68 @@ void map_erase(int x, int y)
 
 void add_plant(int x, int y)
 {
-    MapItem* p = (MapItem*)malloc(sizeof(MapItem));
-    p->type = PLANT;
-    p->draw = draw_plant;
-    p->walkable = true;
-    p->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), p);
-    if (val) free(val); // if something is already there, free it
+    place_item(x, y, tile(TILE_PLANT));
 }
 
 void add_npc(int x, int y)
 {
-    MapItem* npc1 = (MapItem*)malloc(sizeof(MapItem));
-    npc1->type = NPC;
-    npc1->draw = draw_npc;
-    npc1->walkable = false;
-    npc1->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), npc1);
-    if (val) free(val);
+    place_item(x, y, tile(TILE_NPC));
 }
 
 void add_water(int x, int y)
 {
-    MapItem* w = (MapItem*)malloc(sizeof(MapItem));
-    w->type = WATER;
-    w->draw = draw_water;
-    w->walkable = true;
-    w->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), w);
-    if (val) free(val);
+    place_item(x, y, tile(TILE_WATER));
 }
 
 void add_fire(int x, int y)
 {
-    MapItem* f = (MapItem*)malloc(sizeof(MapItem));
-    f->type = FIRE;
-    f->draw = draw_fire;
-    f->walkable = true;
-    f->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), f);
-    if (val) free(val);
+    place_item(x, y, tile(TILE_FIRE));
 }
 
 void add_earth(int x, int y)
 {
-    MapItem* e = (MapItem*)malloc(sizeof(MapItem));
-    e->type = EARTH;
-    e->draw = draw_earth;
-    e->walkable = true;
-    e->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), e);
-    if (val) free(val);
+    place_item(x, y, tile(TILE_EARTH));
 }
 
 
 void add_buzz(int x, int y)
 {
-    MapItem* b = (MapItem*)malloc(sizeof(MapItem));
-    b->type = BUZZ;
-    b->draw = draw_buzz;
-    b->walkable = false;
-    b->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), b);
-    if (val) free(val);
+    place_item(x, y, tile(TILE_BUZZ));
 }
 
 void add_slain_buzz(int x, int y)
 {
     // this function is to ovewrite Buzz when he is defeated
-    MapItem* sb = (MapItem*)malloc(sizeof(MapItem));
-    sb->type = SLAIN_BUZZ;
-    sb->draw = draw_slain_buzz;
-    sb->walkable = false;
-    sb->data = NULL; 
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), sb);
-    if (val) free(val);
+    place_item(x, y, tile(TILE_SLAIN_BUZZ));
 }
 
 void add_wreck(int x, int y) {
-    MapItem* rw = (MapItem*)malloc(sizeof(MapItem));
-    rw->type = RAMBLIN_WRECK;
-    rw->draw = draw_wreck;
-    rw->walkable = false;
-    rw->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), rw);
-    if (val) free(val);
+    place_item(x, y, tile(TILE_WRECK));
 }
 
 void add_pebble(int x, int y)
 {
-    MapItem* p = (MapItem*) malloc(sizeof(MapItem));
-    p->type = PEBBLE;
-    p->draw = draw_pebble;
-    p->walkable = true;
-    p->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x,y), p);
-    if (val) free(val); // if something is already there, free it
+    place_item(x, y, tile(TILE_PEBBLE));
 }
 
 void add_power_up(int x, int y)
 {
-    MapItem* pu = (MapItem*) malloc(sizeof(MapItem));
-    pu->type = POWER_UP;
-    pu->draw = draw_power_up;
-    pu->walkable = true;
-    pu->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x,y), pu);
-    if (val) free(val); // if something is already there, free it
+    place_item(x, y, tile(TILE_POWER_UP));
 }
 
 void add_gift_box(int x, int y)
 {
-    MapItem* gb = (MapItem*) malloc(sizeof(MapItem));
-    gb->type = GIFT_BOX;
-    gb->draw = draw_gift_box;
-    gb->walkable = false;
-    gb->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x,y), gb);
-    if (val) free(val); // if something is already there, free it
-
+    place_item(x, y, tile(TILE_GIFT_BOX));
 }
 
 void add_bush(int x, int y)
 {
-    MapItem* b = (MapItem*) malloc(sizeof(MapItem));
-    b->type = BUSH;
-    b->draw = draw_bush;
-    b->walkable = true;
-    b->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x,y), b);
-    if (val) free(val); // if something is already there, free it
+    place_item(x, y, tile(TILE_BUSH));
 }
 
 void add_hole(int x, int y)
 {
-    MapItem* h = (MapItem*) malloc(sizeof(MapItem));
-    h->type = HOLE;
-    h->draw = draw_hole;
-    h->walkable = true;
-    h->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x,y), h);
-    if (val) free(val); // if something is already there, free it
+    place_item(x, y, tile(TILE_HOLE));
 }
 
 ///////////////////////////////////////
@@ -431,14 +1420,8 @@ void add_wall(int x, int y, int dir, int len)
 {
     for(int i = 0; i < len; i++)
     {
-        MapItem* w1 = (MapItem*) malloc(sizeof(MapItem));
-        w1->type = WALL;
-        w1->draw = draw_wall;
-        w1->walkable = false;
-        w1->data = NULL;
-        unsigned key = (dir == HORIZONTAL) ? XY_KEY(x+i, y) : XY_KEY(x, y+i);
-        void* val = insertItem(get_active_map()->items, key, w1);
-        if (val) free(val); // if something is already there, free it
+        if (dir == HORIZONTAL) place_item(x+i, y, tile(TILE_WALL));
+        else place_item(x, y+i, tile(TILE_WALL));
     }
 }
 
@@ -446,58 +1429,25 @@ void add_door(int x, int y, int dir, int len)
 {
     for(int i = 0; i < len; i++)
     {
-        MapItem* w1 = (MapItem*) malloc(sizeof(MapItem));
-        w1->type = DOOR;
-        w1->draw = draw_door;
-        w1->walkable = false;
-        w1->data = NULL;
-        unsigned key = (dir == HORIZONTAL) ? XY_KEY(x+i, y) : XY_KEY(x, y+i);
-        void* val = insertItem(get_active_map()->items, key, w1);
-        if (val) free(val); // if something is already there, free it
+        if (dir == HORIZONTAL) place_item(x+i, y, tile(TILE_DOOR));
+        else place_item(x, y+i, tile(TILE_DOOR));
     }
 }
 
 
 void add_stairs(int x, int y, int tm, int tx, int ty)
 {
-    MapItem* w1 = (MapItem*) malloc(sizeof(MapItem));
-    w1->type = STAIRS;
-    w1->draw = draw_stairs;
-    w1->walkable = true;
-    StairsData* data = (StairsData*) malloc(sizeof(StairsData));
-    data->tm = tm;
-    data->tx = tx;
-    data->ty = ty;
-    w1->data = data;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), w1);
-    if (val) free(val); // if something is already there, free it
+    place_item(x, y, new_portal(get_active_map(), TILE_STAIRS, tm, tx, ty));
 }
 
 
 void add_cave(int x, int y, int n, int tm, int tx, int ty)
 {
-    MapItem* w1 = (MapItem*) malloc(sizeof(MapItem));
-    w1->type = CAVE;
-    if (n==1){
-        w1->draw = draw_cave1;
-    }
-    if (n==2){
-        w1->draw = draw_cave2;
-    }
-    if (n==3){
-        w1->draw = draw_cave3;
-    }
-    if (n==4){
-        w1->draw = draw_cave4;
-    }
-    w1->walkable = true;
-    StairsData* data = (StairsData*) malloc(sizeof(StairsData));
-    data->tm = tm;
-    data->tx = tx;
-    data->ty = ty;
-    w1->data = data;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), w1);
-    if (val) free(val); // if something is already there, free it
+    // caves 1 to 4 are the four corners of one 2x2 picture
+    MapItem* cave = new_portal(get_active_map(), TILE_CAVE1 + (n >= 1 && n <= 4 ? n - 1 : 0),
+                               tm, tx, ty);
+    if (n < 1 || n > 4) cave->draw = NULL;
+    place_item(x, y, cave);
 }
 
 
@@ -505,54 +1455,181 @@ void add_mud(int x, int y, int dir, int len)
 {
     for(int i = 0; i < len; i++)
     {
-        MapItem* w1 = (MapItem*) malloc(sizeof(MapItem));
-        w1->type = MUD;
-        w1->draw = draw_mud;
-        w1->walkable = true;
-        w1->data = NULL;
-        unsigned key = (dir == HORIZONTAL) ? XY_KEY(x+i, y) : XY_KEY(x, y+i);
-        void* val = insertItem(get_active_map()->items, key, w1);
-        if (val) free(val); // if something is already there, free it
+        if (dir == HORIZONTAL) place_item(x+i, y, tile(TILE_MUD));
+        else place_item(x, y+i, tile(TILE_MUD));
     }
 }
 
 void add_secret_entrance(int x, int y, int tm, int tx, int ty)
 {
-    MapItem* e = (MapItem*) malloc(sizeof(MapItem));
-    e->type = SECRET_DOOR;
-    e->draw = draw_secret_entrance;
-    e->walkable = true;
-    StairsData* data = (StairsData*) malloc(sizeof(StairsData));
-    data->tm = tm;
-    data->tx = tx;
-    data->ty = ty;
-    e->data = data;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), e);
-    if (val) free(val); // if something is already there, free it
+    place_item(x, y, new_portal(get_active_map(), TILE_SECRET_DOOR, tm, tx, ty));
 }
 
 void add_secret_stairs(int x, int y, int tm, int tx, int ty)
 {
-    MapItem* s = (MapItem*) malloc(sizeof(MapItem));
-    s->type = STAIRS;
-    s->draw = draw_secret_stairs;
-    s->walkable = true;
-    StairsData* data = (StairsData*) malloc(sizeof(StairsData));
-    data->tm = tm;
-    data->tx = tx;
-    data->ty = ty;
-    s->data = data;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x, y), s);
-    if (val) free(val); // if something is already there, free it
+    place_item(x, y, new_portal(get_active_map(), TILE_SECRET_STAIRS, tm, tx, ty));
 }
 
 void add_mushroom(int x, int y)
 {
-    MapItem* m = (MapItem*) malloc(sizeof(MapItem));
-    m->type = MUSHROOM;
-    m->draw = draw_mushroom;
-    m->walkable = true;
-    m->data = NULL;
-    void* val = insertItem(get_active_map()->items, XY_KEY(x,y), m);
-    if (val) free(val); // if something is already there, free it
+    place_item(x, y, tile(TILE_MUSHROOM));
+}
+
+
+///////////////////////////////////////
+// Map Files
+///////////////////////////////////////
+
+/**
+ * returns the tile kind of an item (see map_format.h), or MAP_FILE_EMPTY if
+ * the cell is empty or the item is not one the add_* functions make.
+ */
+static int item_kind(MapItem* item)
+{
+    if (!item) return MAP_FILE_EMPTY;
+    for (int kind = 0; kind < NUM_TILE_KINDS; kind++) {
+        if (PROTOTYPES[kind].type == item->type && PROTOTYPES[kind].draw == item->draw) {
+            return kind;
+        }
+    }
+    return MAP_FILE_EMPTY;
+}
+
+int map_save(const char* path)
+{
+    Map* map = get_active_map();
+    int area = map->w * map->h;
+    int num_portals = 0;
+
+    // the tile grid, counting the portals on the way
+    unsigned char* tiles = (unsigned char*)malloc(area);
+    for (int k = 0; k < area; k++) {
+        tiles[k] = item_kind(map_lookup(k % map->w, k / map->w));
+        if (tiles[k] != MAP_FILE_EMPTY && tiles[k] >= TILE_FIRST_PORTAL) num_portals++;
+    }
+
+    // a record for every portal
+    MapFilePortal* portals = (MapFilePortal*)calloc(num_portals + 1, sizeof(MapFilePortal));
+    for (int k = 0, n = 0; n < num_portals; k++) {
+        if (tiles[k] == MAP_FILE_EMPTY || tiles[k] < TILE_FIRST_PORTAL) continue;
+        StairsData* data = (StairsData*)map_lookup(k % map->w, k / map->w)->data;
+        portals[n].x = k % map->w;
+        portals[n].y = k / map->w;
+        portals[n].tx = data->tx;
+        portals[n].ty = data->ty;
+        portals[n].kind = tiles[k];
+        portals[n].tm = data->tm;
+        n++;
+    }
+
+    MapFileHeader header;
+    header.magic = MAP_FILE_MAGIC;
+    header.version = MAP_FILE_VERSION;
+    header.num_portals = num_portals;
+    header.width = map->w;
+    header.height = map->h;
+    header.tiles_offset = sizeof(MapFileHeader);
+    header.portals_offset = (header.tiles_offset + area + 3) & ~3u;
+
+    static const unsigned char padding[4] = {0, 0, 0, 0};
+    int ok = 0;
+    FILE* f = fopen(path, "wb");
+    if (f) {
+        ok = fwrite(&header, sizeof(header), 1, f) == 1
+          && fwrite(tiles, 1, area, f) == (size_t)area
+          && fwrite(padding, 1, header.portals_offset - header.tiles_offset - area, f)
+             == header.portals_offset - header.tiles_offset - area
+          && fwrite(portals, sizeof(MapFilePortal), num_portals, f) == (size_t)num_portals;
+        ok = (fclose(f) == 0) && ok;
+    }
+    free(tiles);
+    free(portals);
+    return ok;
+}
+
+int map_attach(int m, const void* image, unsigned int size)
+{
+    const unsigned char* bytes = (const unsigned char*)image;
+    MapFileHeader header;
+    MapFilePortal portal;
+
+    // check that the header, the grid and the portal table all fit in the image
+    if (size < sizeof(MapFileHeader)) return 0;
+    memcpy(&header, bytes, sizeof(header));
+    unsigned int area = (unsigned int)header.width * header.height;
+    if (header.magic != MAP_FILE_MAGIC || header.version != MAP_FILE_VERSION
+        || area == 0 || header.tiles_offset > size || area > size - header.tiles_offset
+        || header.portals_offset > size
+        || header.num_portals * sizeof(MapFilePortal) > size - header.portals_offset) {
+        return 0;
+    }
+
+    Map* map = maps[m];
+    release_storage(map);
+    MappedStore* store = (MappedStore*)arenaAlloc(map->arena, sizeof(MappedStore));
+    store->image = bytes;
+    store->size = size;
+    store->owner = IMAGE_BORROWED;
+    store->grid = bytes + header.tiles_offset;
+    store->overlay = new ItemTable(MHF_NBUCKETS);
+    store->overlaid = (unsigned char*)arenaCalloc(map->arena, (area + 7) / 8, 1);
+    map->mode = MAP_MAPPED;
+    map->mapped = store;
+    map->compact_next = 0;
+    map->w = header.width;
+    map->h = header.height;
+    alloc_bits(map);
+
+    // portals need their own StairsData, so they go in the overlay up front
+    for (unsigned int i = 0; i < header.num_portals; i++) {
+        memcpy(&portal, bytes + header.portals_offset + i * sizeof(MapFilePortal), sizeof(portal));
+        if (portal.x >= header.width || portal.y >= header.height
+            || portal.kind < TILE_FIRST_PORTAL || portal.kind >= NUM_TILE_KINDS) {
+            continue;
+        }
+        int k = portal.x + portal.y * map->w;
+        mapped_store(map, k, new_portal(map, portal.kind, portal.tm, portal.tx, portal.ty));
+    }
+    for (unsigned int k = 0; k < area; k++) update_bits(map, k, mapped_lookup(map, k));
+    // a map that was just attached has to be drawn in full anyway
+    memset(map->dirty, 0, (area + 31) / 32 * sizeof(uint32_t));
+    return 1;
+}
+
+int map_load_file(int m, const char* path)
+{
+#ifdef HAVE_MMAP
+    // map the file read-only: tiles are read straight out of the page cache
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    void* image = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (image == MAP_FAILED) return 0;
+    if (!map_attach(m, image, st.st_size)) {
+        munmap(image, st.st_size);
+        return 0;
+    }
+    maps[m]->mapped->owner = IMAGE_MMAPPED;
+    return 1;
+#else
+    // no mmap on the target: read the file into the heap once instead
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    void* image = (size > 0) ? malloc(size) : NULL;
+    int ok = image && fread(image, 1, size, f) == (size_t)size;
+    fclose(f);
+    if (!ok || !map_attach(m, image, size)) {
+        free(image);
+        return 0;
+    }
+    maps[m]->mapped->owner = IMAGE_MALLOCED;
+    return 1;
+#endif
 }
@@ -93,35 +93,179 @@ typedef struct {
 #define MUSHROOM        22
 
 /**
- * Initializes the internal structures for all maps. This does not populate
- * the map with items, but allocates space for them, initializes the hash tables, 
- * and sets the width and height.
+ * Initializes the map registry, which starts out empty. Call it once, before
+ * any other function in this header.
  */
 void maps_init();
 
+// Storage modes, for map_create. A dense map is a grid with a slot for every
+// cell: it spends one pointer per cell, but every access is a single array
+// index, so it suits maps that are more than about a tenth full. A sparse map
+// is a hash table holding only the stored items. Every function in this
+// header behaves the same either way, except that a dense map ignores items
+// added outside its bounds.
+#define MAP_DENSE   0
+#define MAP_SPARSE  1
+
+// A chunked map only keeps the chunks it touched recently in memory (see
+// map_init_chunked), and a mapped map serves its tiles straight from a map
+// file image (see map_attach). Pass these to map_create when the builder
+// sets the storage up itself.
+#define MAP_CHUNKED 2
+#define MAP_MAPPED  3
+
+/**
+ * Fills in map m, which is active while the builder runs. The builder either
+ * adds items with the add_* functions, or replaces the map's storage with
+ * map_attach, map_load_file or map_init_chunked.
+ */
+typedef void (*MapBuilder)(int m, void* context);
+
+/**
+ * Adds a w x h map to the registry and returns its handle, the m every other
+ * function takes: the first map created is 0, the next 1, and so on. Nothing
+ * is allocated for its contents yet. The first time the map is made active
+ * it gets empty storage of the given mode (MAP_DENSE or MAP_SPARSE) and
+ * build(m, context) is called to fill it in; build may be NULL. For
+ * MAP_CHUNKED or MAP_MAPPED the builder must set the storage up itself,
+ * otherwise the map is left empty and sparse.
+ *
+ * Each map allocates everything it stores from an arena of its own, so
+ * replacing what a map holds (map_clear, map_attach, ...) drops all of it at
+ * once and reuses the memory, rather than freeing item by item.
+ */
+int map_create(int w, int h, int storage, MapBuilder build, void* context);
+
+/**
+ * Returns the number of maps created so far.
+ */
+int map_count();
+
+/**
+ * Frees everything map m holds, leaving only what map_create was given, so
+ * that the next set_active_map(m) builds it again from scratch; changes made
+ * to it are lost. A chunked map saves its changed chunks first. A map can't
+ * be unloaded while it is active, or while a stairs, cave or secret door on
+ * another loaded map leads to it. Returns nonzero if the map is unloaded.
+ */
+int map_unload(int m);
+
 /**
  * Returns a pointer to the active map.
  */
 Map* get_active_map();
 
 /**
- * Sets the active map to map m, where m is the index of the map to activate.
+ * Sets the active map to map m, where m is the handle of the map to activate,
+ * building the map first if it isn't loaded.
  * Returns a pointer to the new active map.
  */
 Map* set_active_map(int m);
 
 /**
  * Returns the map m, regardless of whether it is the active map. This function
- * does not change the active map.
+ * does not change the active map, and does not load the map.
  */
 Map* get_map(int m);
 
+/**
+ * Empties map m in one step so it can be filled again, with a newly
+ * generated level for instance. Its items are dropped all at once and the
+ * map keeps its size. A sparse map stays sparse; a dense or mapped one
+ * becomes an empty dense map. A chunked map drops its chunks, which are
+ * loaded again the next time they are touched. A map that isn't loaded is
+ * left alone.
+ */
+void map_clear(int m);
+
+/**
+ * The width and height, in tiles, of one chunk of a chunked map.
+ */
+#define CHUNK_SIZE 16
+
+/**
+ * Fills in chunk (cx,cy) of a chunked map, which covers the tiles with
+ * cx*CHUNK_SIZE <= x < (cx+1)*CHUNK_SIZE and cy*CHUNK_SIZE <= y < (cy+1)*CHUNK_SIZE.
+ * The chunk starts out empty and the map is active while the loader runs, so
+ * the loader simply calls the add_* functions. It should only add items inside
+ * its own chunk.
+ */
+typedef void (*ChunkLoader)(int cx, int cy, void* context);
+
+/**
+ * Called just before a chunk that changed since it was loaded is evicted.
+ * tiles holds its CHUNK_SIZE*CHUNK_SIZE items in row-major order (NULL for
+ * empty cells). The items are freed right after, so copy what you need to
+ * restore them the next time the loader runs.
+ */
+typedef void (*ChunkSaver)(int cx, int cy, MapItem** tiles, void* context);
+
+/**
+ * Replaces the storage of map m (and everything in it) with an empty, w x h
+ * chunked map for worlds too large to keep in memory. A chunk is only loaded
+ * when a lookup or an add_* function touches it, and at most budget chunks
+ * stay in memory: loading one more evicts the least recently used chunk.
+ * Without a saver, chunks that changed since they were loaded are never
+ * evicted, so the map can grow past its budget. The budget should cover the
+ * 2x2 chunks the screen can span. Items outside the map are ignored, and
+ * map_for_each only visits the chunks in memory.
+ */
+void map_init_chunked(int m, int w, int h, int budget, ChunkLoader load, ChunkSaver save,
+                      void* context);
+
+/**
+ * Writes the active map to a binary map file (see map_format.h).
+ * Returns nonzero on success.
+ */
+int map_save(const char* path);
+
+/**
+ * Replaces the storage of map m (and everything in it) with a map file image
+ * already in memory, such as a const array in flash. Tiles are read straight
+ * from the image, which must stay valid and unchanged while it is attached;
+ * portals and any later changes are kept in a small hash table on top.
+ * Returns zero, leaving map m untouched, if the image is not a valid map file.
+ */
+int map_attach(int m, const void* image, unsigned int size);
+
+/**
+ * Like map_attach, for a map file on disk. On the host the file is
+ * memory-mapped read-only, so loading copies nothing; on the mbed it is read
+ * into the heap once. Returns zero if the file can't be read or is invalid.
+ */
+int map_load_file(int m, const char* path);
+
 /**
  * Print the active map to the serial console.
  */
 void print_map();
 
+/**
+ * Prints the size, load factor and chain-length histogram of the active
+ * map's hash table over the serial console, to help tune its hash function
+ * and initial size. The lookup counters are included when built with HT_STATS.
+ */
+void print_map_stats();
+
+/**
+ * A function pointer type for visiting the items of a map.
+ * (x,y) is the location of the item.
+ */
+typedef void (*MapItemVisitor)(int x, int y, MapItem* item, void* context);
+
+/**
+ * Calls visit(x, y, item, context) once for every item stored in the active
+ * map, in storage order. Empty cells are skipped, so the cost depends on
+ * the number of items rather than the area of the map.
+ * The map must not be modified from inside visit.
+ */
+void map_for_each(MapItemVisitor visit, void* context);
+
 // Access
+// None of the functions that read items change the map, so reading the
+// same cell twice gives the same item. (A chunked map may still load or
+// evict chunks to answer.)
+
 /**
  * Returns the width of the active map.
  */
@@ -162,15 +306,112 @@ MapItem* get_west(int x, int y);
  */
 MapItem* get_here(int x, int y);
 
+/**
+ * Looks up n locations of the active map in one call and writes the MapItem
+ * at (xs[i], ys[i]) to items[i], exactly as get_here would, except that
+ * locations outside the map give NULL. The lookups are batched in the hash
+ * table, so this is cheaper than n separate get_here calls.
+ */
+void get_items(int n, const int* xs, const int* ys, MapItem** items);
+
+/**
+ * Fills items, a w*h buffer in row-major order, with the MapItems of the
+ * w x h region of the active map whose top left corner is (x,y): the item at
+ * (x+i, y+j) goes to items[j*w + i], exactly as get_here would return it,
+ * except that locations outside the map give NULL. The region is read a row
+ * at a time straight from the map's storage, so this is much cheaper than
+ * w*h separate get_here calls.
+ */
+void get_region(int x, int y, int w, int h, MapItem** items);
+
+/**
+ * The index in a get_neighborhood buffer of the item at offset (dx,dy) from
+ * the center.
+ */
+#define NEIGHBOR(radius, dx, dy) (((dy) + (radius)) * (2 * (radius) + 1) + (dx) + (radius))
+
+/**
+ * Fills items, a (2*radius+1) x (2*radius+1) buffer, with the square of
+ * MapItems centered on (x,y), as get_region would. With radius 1 that is
+ * here, the four neighbors and the four corners in one call:
+ * items[NEIGHBOR(1, 0, -1)] is the item get_north(x, y) returns.
+ */
+void get_neighborhood(int x, int y, int radius, MapItem** items);
+
+// Compass directions, for map_ray
+#define DIR_NORTH   0
+#define DIR_SOUTH   1
+#define DIR_EAST    2
+#define DIR_WEST    3
+
+/**
+ * Walks from (x,y) in direction dir, one tile at a time, and returns the
+ * number of tiles that can be walked on before the first one that blocks
+ * motion, up to n. (x,y) itself is not checked. Empty cells can be walked
+ * on; cells outside the map can't.
+ */
+int map_ray(int x, int y, int dir, int n);
+
+/**
+ * Returns nonzero if the player can walk onto (x,y) on the active map: the
+ * cell is inside the map and is empty or holds a walkable item.
+ *
+ * Every map except a chunked one keeps a bitmap of its blocked cells (and
+ * one of its hazards) up to date as items are added and erased, so this and
+ * the functions below read bits rather than items. On a chunked map they
+ * look the items up instead.
+ */
+int map_walkable(int x, int y);
+
+/**
+ * Returns nonzero if the item at (x,y) on the active map hurts the player
+ * when stepped on (a pebble or a hole).
+ */
+int map_hazard(int x, int y);
+
+/**
+ * Returns the number of cells of the w x h region whose top left corner is
+ * (x,y) that the player can't walk onto. Cells outside the map count as
+ * blocked, so zero means the whole region can be walked on.
+ */
+int map_count_blocked(int x, int y, int w, int h);
+
+/**
+ * Returns the number of hazards (see map_hazard) in the w x h region whose
+ * top left corner is (x,y).
+ */
+int map_count_hazards(int x, int y, int w, int h);
+
+/**
+ * Reports which cells of the w x h region whose top left corner is (x,y)
+ * changed since they were last consumed, and marks them unchanged. A cell
+ * changes whenever an item is added, replaced or erased there.
+ * changed[j*w + i] is set to 1 if (x+i, y+j) changed and to 0 if not;
+ * changed may be NULL to just clear the region. Returns the number of
+ * changed cells. Cells outside the map never change. A chunked map does
+ * not track changes, so every cell inside it is reported as changed.
+ */
+int map_consume_dirty(int x, int y, int w, int h, unsigned char* changed);
+
 // Directions, for using the modification functions
 #define HORIZONTAL  0
 #define VERTICAL    1
 
 /**
- * If there is a MapItem at (x,y), remove it from the map.
+ * If there is a MapItem at (x,y), remove it from the map. The cell is empty
+ * right away, and is reported by map_consume_dirty so it gets redrawn.
  */
 void map_erase(int x, int y);
 
+/**
+ * Does a bounded amount of housekeeping on the active map, so it never
+ * stalls a frame: looks at up to n cells, continuing where the last call
+ * stopped, and drops the changes a mapped map keeps on top of its image that
+ * only repeat what the image already holds. Returns the number of entries
+ * dropped. Other kinds of map delete items outright and have nothing to do.
+ */
+int map_compact(int n);
+
 /**
  * Add WALL items in a line of length len beginning at (x,y).
  * If dir == HORIZONTAL, the line is in the direction of increasing x.
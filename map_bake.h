@@ -0,0 +1,199 @@
+// ============================================
+// Compile-time baking of ASCII map layouts.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+/****************************************************************************
+ * bake_map<W, H>(layout, portals)
+ *
+ * Turns an ASCII picture of a map into a complete map file image (see
+ * map_format.h) while the program is being compiled. The result is a
+ * constexpr object, so it is placed in flash with the rest of the read-only
+ * data, and map_attach can serve the map straight from it: starting a map
+ * takes no parsing and no add_* calls, and its tiles take no heap at all.
+ *
+ * A layout is a string of W*H characters, one per cell in row-major order,
+ * written one row per line like the sprites in graphics.cpp:
+ *
+ *      ' ' empty           'W' wall            'D' door
+ *      'P' plant           'A' water           'N' NPC
+ *      'M' mud             'F' fire            'R' Ramblin' Wreck
+ *      'E' earth           'B' Buzz            'b' slain Buzz
+ *      '.' pebble          '+' power-up        'G' gift box
+ *      'U' bush            'O' hole            'm' mushroom
+ *      'S' stairs          's' secret stairs   '#' secret door
+ *      '1' '2' '3' '4'     the top left, top right, bottom left and bottom
+ *                          right corners of a cave
+ *
+ * The last two rows are portals: every portal cell also needs a LayoutPortal
+ * saying where it takes the player. Check a layout with layout_ok, which
+ * fails to compile (in a static_assert) on an unknown character, a layout of
+ * the wrong length, or portals that don't match the portal cells:
+ *
+ *     constexpr char ROOM[] =
+ *         "WWWW"
+ *         "W S "
+ *         "WWWW";
+ *     constexpr LayoutPortal ROOM_PORTALS[] = {{2, 1, 0, 5, 5}};
+ *     static_assert(layout_ok<4, 3>(ROOM, ROOM_PORTALS), "bad room");
+ *     constexpr auto ROOM_MAP = bake_map<4, 3>(ROOM, ROOM_PORTALS);
+ *     map_attach(1, &ROOM_MAP, sizeof(ROOM_MAP));
+ *
+ * This needs a C++11 compiler.
+ ***************************************************************************/
+#ifndef MAP_BAKE_H
+#define MAP_BAKE_H
+
+#include "map_format.h"
+#include "indices.h"
+
+/** The tile byte of a character that is not in the layout alphabet */
+#define LAYOUT_UNKNOWN 0xFE
+
+/**
+ * Where a portal cell of a layout takes the player: to (tx,ty) on map tm.
+ */
+struct LayoutPortal {
+    uint16_t x, y;            // location of the portal cell in the layout
+    uint8_t tm;               // the map it takes the player to
+    uint16_t tx, ty;          // where on that map
+};
+
+/**
+ * A map file image with room for a W x H tile grid and P portal records,
+ * laid out exactly as map_format.h describes.
+ */
+template <int W, int H, int P>
+struct BakedMap {
+    MapFileHeader header;
+    uint8_t tiles[(W * H + 3) & ~3];    // padded so the portals are 4-byte aligned
+    MapFilePortal portals[P];
+};
+
+/**
+ * Returns the tile kind of a layout character, MAP_FILE_EMPTY for a space, or
+ * LAYOUT_UNKNOWN.
+ */
+constexpr uint8_t layout_tile(char c)
+{
+    return c == ' ' ? MAP_FILE_EMPTY
+         : c == 'W' ? TILE_WALL
+         : c == 'D' ? TILE_DOOR
+         : c == 'P' ? TILE_PLANT
+         : c == 'A' ? TILE_WATER
+         : c == 'N' ? TILE_NPC
+         : c == 'M' ? TILE_MUD
+         : c == 'F' ? TILE_FIRE
+         : c == 'R' ? TILE_WRECK
+         : c == 'E' ? TILE_EARTH
+         : c == 'B' ? TILE_BUZZ
+         : c == 'b' ? TILE_SLAIN_BUZZ
+         : c == '.' ? TILE_PEBBLE
+         : c == '+' ? TILE_POWER_UP
+         : c == 'G' ? TILE_GIFT_BOX
+         : c == 'U' ? TILE_BUSH
+         : c == 'O' ? TILE_HOLE
+         : c == 'm' ? TILE_MUSHROOM
+         : c == 'S' ? TILE_STAIRS
+         : c == 's' ? TILE_SECRET_STAIRS
+         : c == '#' ? TILE_SECRET_DOOR
+         : c == '1' ? TILE_CAVE1
+         : c == '2' ? TILE_CAVE2
+         : c == '3' ? TILE_CAVE3
+         : c == '4' ? TILE_CAVE4
+         : LAYOUT_UNKNOWN;
+}
+
+// the machinery below is written for C++11 constexpr functions, which are a
+// single return statement. loops over the cells of a layout are split in
+// halves rather than recursing cell by cell, which keeps the recursion depth
+// logarithmic in the size of the map.
+namespace map_bake {
+
+constexpr bool is_portal(uint8_t kind)
+{
+    return kind != MAP_FILE_EMPTY && kind != LAYOUT_UNKNOWN && kind >= TILE_FIRST_PORTAL;
+}
+
+/** Whether every character of layout[lo, hi) is in the layout alphabet */
+constexpr bool all_known(const char* layout, int lo, int hi)
+{
+    return hi - lo == 1 ? layout_tile(layout[lo]) != LAYOUT_UNKNOWN
+         : all_known(layout, lo, (lo + hi) / 2) && all_known(layout, (lo + hi) / 2, hi);
+}
+
+/** The number of portal cells in layout[lo, hi) */
+constexpr int count_portals(const char* layout, int lo, int hi)
+{
+    return hi - lo == 1 ? (is_portal(layout_tile(layout[lo])) ? 1 : 0)
+         : count_portals(layout, lo, (lo + hi) / 2) + count_portals(layout, (lo + hi) / 2, hi);
+}
+
+/** Whether portal i is the only one of portals[i, n) at its location */
+constexpr bool unique_from(const LayoutPortal* portals, int i, int j, int n)
+{
+    return j >= n || ((portals[i].x != portals[j].x || portals[i].y != portals[j].y)
+                      && unique_from(portals, i, j + 1, n));
+}
+
+/** Whether portals[i, n) all sit on distinct portal cells of the layout */
+constexpr bool portals_placed(const char* layout, int w, int h,
+                              const LayoutPortal* portals, int i, int n)
+{
+    return i >= n || (portals[i].x < w && portals[i].y < h
+                      && is_portal(layout_tile(layout[portals[i].x + portals[i].y * w]))
+                      && unique_from(portals, i, i + 1, n)
+                      && portals_placed(layout, w, h, portals, i + 1, n));
+}
+
+/** The map file record of a layout portal */
+constexpr MapFilePortal portal_record(const char* layout, int w, const LayoutPortal& p)
+{
+    return MapFilePortal{p.x, p.y, p.tx, p.ty, layout_tile(layout[p.x + p.y * w]), p.tm, 0};
+}
+
+template <int W, int H, int P, unsigned... T, unsigned... Q>
+constexpr BakedMap<W, H, P> bake(const char* layout, const LayoutPortal* portals,
+                                 Indices<T...>, Indices<Q...>)
+{
+    return BakedMap<W, H, P>{
+        {MAP_FILE_MAGIC, MAP_FILE_VERSION, P, W, H, sizeof(MapFileHeader),
+         sizeof(MapFileHeader) + ((W * H + 3) & ~3)},
+        {(T < W * H ? layout_tile(layout[T]) : (uint8_t)MAP_FILE_EMPTY)...},
+        {portal_record(layout, W, portals[Q])...}
+    };
+}
+
+} // namespace map_bake
+
+/**
+ * Whether a layout and its portals can be baked: the layout holds exactly
+ * W*H known characters, and there is one portal per portal cell.
+ */
+template <int W, int H, int N, int P>
+constexpr bool layout_ok(const char (&layout)[N], const LayoutPortal (&portals)[P])
+{
+    return N == W * H + 1
+        && map_bake::all_known(layout, 0, W * H)
+        && map_bake::count_portals(layout, 0, W * H) == P
+        && map_bake::portals_placed(layout, W, H, portals, 0, P);
+}
+
+/**
+ * Bakes a layout and its portals into a map file image. Check them with
+ * layout_ok first: bake_map takes any layout it is given.
+ */
+template <int W, int H, int N, int P>
+constexpr BakedMap<W, H, P> bake_map(const char (&layout)[N], const LayoutPortal (&portals)[P])
+{
+    return map_bake::bake<W, H, P>(layout, portals,
+                                   typename MakeIndices<(W * H + 3) & ~3>::type(),
+                                   typename MakeIndices<P>::type());
+}
+
+#endif // MAP_BAKE_H
@@ -0,0 +1,91 @@
+//=================================================================
+// The binary map file format.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#ifndef MAP_FORMAT_H
+#define MAP_FORMAT_H
+
+#include <stdint.h>
+
+/**
+ * A map file holds one map, laid out so that it can be used in place: map.cpp
+ * reads tiles straight out of a memory-mapped file or an image in flash
+ * (see map_attach in map.h) instead of building the map item by item.
+ *
+ *   MapFileHeader                      at offset 0
+ *   uint8_t tiles[width * height]      at tiles_offset, row-major
+ *   MapFilePortal portals[num_portals] at portals_offset (4-byte aligned)
+ *
+ * Every tile is a tile kind, or MAP_FILE_EMPTY. Portals (stairs, caves and
+ * secret doors) also need a destination, so each portal tile has a record
+ * too. All fields are little-endian, which both the LPC1768 and the host are.
+ */
+
+/** "MAP1" read as a little-endian word */
+#define MAP_FILE_MAGIC   0x3150414Du
+#define MAP_FILE_VERSION 1
+
+/** The tile byte of an empty cell */
+#define MAP_FILE_EMPTY   0xFF
+
+/**
+ * The kinds of tile a map can hold. A kind is a MapItem type together with
+ * its look, so the four corners of a cave and the secret stairs are kinds of
+ * their own. These values are stored in map files: only add to the end.
+ */
+enum {
+    TILE_WALL = 0,
+    TILE_DOOR,
+    TILE_PLANT,
+    TILE_WATER,
+    TILE_NPC,
+    TILE_MUD,
+    TILE_FIRE,
+    TILE_WRECK,
+    TILE_EARTH,
+    TILE_BUZZ,
+    TILE_SLAIN_BUZZ,
+    TILE_PEBBLE,
+    TILE_POWER_UP,
+    TILE_GIFT_BOX,
+    TILE_BUSH,
+    TILE_HOLE,
+    TILE_MUSHROOM,
+    // portals: every tile of these kinds has a MapFilePortal record
+    TILE_STAIRS,
+    TILE_SECRET_STAIRS,
+    TILE_SECRET_DOOR,
+    TILE_CAVE1,
+    TILE_CAVE2,
+    TILE_CAVE3,
+    TILE_CAVE4,
+    NUM_TILE_KINDS
+};
+
+/** The first portal kind; every kind from here on is a portal */
+#define TILE_FIRST_PORTAL TILE_STAIRS
+
+typedef struct {
+    uint32_t magic;           // MAP_FILE_MAGIC
+    uint16_t version;         // MAP_FILE_VERSION
+    uint16_t num_portals;     // number of MapFilePortal records
+    uint16_t width, height;   // map dimensions in tiles
+    uint32_t tiles_offset;    // file offset of the tile grid
+    uint32_t portals_offset;  // file offset of the portal records
+} MapFileHeader;
+
+typedef struct {
+    uint16_t x, y;            // location of the portal tile
+    uint16_t tx, ty;          // where it takes the player
+    uint8_t kind;             // its tile kind, one of the portal kinds
+    uint8_t tm;               // the map it takes the player to
+    uint16_t reserved;        // zero
+} MapFilePortal;
+
+#endif // MAP_FORMAT_H
@@ -0,0 +1,163 @@
+//=================================================================
+// The built-in map layouts.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#include "map_layouts.h"
+#include "map_bake.h"
+
+// the characters of a layout are listed in map_bake.h. every layout is
+// checked and baked while compiling, so a typo is a compile error rather
+// than a broken map.
+
+
+/////////////////////////
+// Main Map
+/////////////////////////
+
+/**
+ * the main world map: walls around the edges, an extra chamber with a door
+ * and the Ramblin' Wreck at the top, plants, bushes, pebbles and power-ups
+ * in the background so you can see motion, holes, the NPC, the cave down to
+ * Buzz's evil lair and the secret entrance in the bottom right corner.
+ */
+static constexpr char MAIN_LAYOUT[] =
+    "WWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWW"
+    "W  P                          W        W  P      W"
+    "W                             WP     U W         W"
+    "W+   U              P         W        W    U    W"
+    "W        P  U                 W        W        PW"
+    "W                  UN         W      P W         W"
+    "W                         U   W        W         W"
+    "W             +P              W  U     W         W"
+    "WU. P     .                   W        WU  P     W"
+    "W       U                     W P  R   W       U W"
+    "W         O .  U    .P        WWWDDDDWWW         W"
+    "W         P           U    +                     W"
+    "W                     .      U.       P          W"
+    "W                          P        U            W"
+    "W   U           P               .       .  U     W"
+    "W    P     U                            +   P    W"
+    "W                 U              P        .      W"
+    "W                     P  U                       W"
+    "W          P                    U                W"
+    "W .+                                   U         W"
+    "W    12U            O       P                 U  W"
+    "W   .34     . U  P                               W"
+    "W     P              U                       P   W"
+    "W             . +     .     U     P              W"
+    "W                      P           U             W"
+    "W  U        P           .       .         U      W"
+    "WP        U                  +          P        W"
+    "W                U           P    .       .      W"
+    "W                 P     U                        W"
+    "W      P                       U            . P  W"
+    "W                             O    P  U   +      W"
+    "W     U                 P                    U   W"
+    "W    .       P                                   W"
+    "W P                 U                    P       W"
+    "W    + .       .           U  P                  W"
+    "W                  P              U              W"
+    "W U     P        .       .               U     P W"
+    "W        U                          P           UW"
+    "W               U +      P .       .             W"
+    "W             P        U                         W"
+    "W  P                          U      .  O P  .   W"
+    "W                              P     U           W"
+    "W    U              P          +            U  . W"
+    "W        P  U                                   PW"
+    "W                  U                 P           W"
+    "W      .                  P                      W"
+    "W              P                 U          +    W"
+    "WU  P    .       .                      U  P     W"
+    "W       U                       P              U#W"
+    "WWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWW";
+
+// the cave (a 2x2 block) leads to the small map, the secret entrance to the
+// secret map
+static constexpr LayoutPortal MAIN_PORTALS[] = {
+    {5,  20, 1, 5, 5},
+    {6,  20, 1, 5, 5},
+    {5,  21, 1, 5, 5},
+    {6,  21, 1, 5, 5},
+    {48, 48, 2, 4, 4},
+};
+
+static_assert(layout_ok<50, 50>(MAIN_LAYOUT, MAIN_PORTALS), "bad main map layout");
+static constexpr auto MAIN_MAP = bake_map<50, 50>(MAIN_LAYOUT, MAIN_PORTALS);
+
+
+/////////////////////////
+// Small Map
+/////////////////////////
+
+/**
+ * Buzz's lair: walls around the edges, Wizard Buzz in the center, the three
+ * spells for the player to use to defeat him, and stairs back up to the cave.
+ */
+static constexpr char SMALL_LAYOUT[] =
+    "WWWWWWWWWWWWWWWW"
+    "W            F W"
+    "W              W"
+    "W              W"
+    "W              W"
+    "W    A   .     W"
+    "W   S          W"
+    "W              W"
+    "W       B      W"
+    "W              W"
+    "W              W"
+    "W              W"
+    "W       E    + W"
+    "W              W"
+    "W              W"
+    "WWWWWWWWWWWWWWWW";
+
+static constexpr LayoutPortal SMALL_PORTALS[] = {
+    {4, 6, 0, 5, 20},
+};
+
+static_assert(layout_ok<16, 16>(SMALL_LAYOUT, SMALL_PORTALS), "bad small map layout");
+static constexpr auto SMALL_MAP = bake_map<16, 16>(SMALL_LAYOUT, SMALL_PORTALS);
+
+
+/////////////////////////
+// Secret Map
+/////////////////////////
+
+/**
+ * the secret map: walls around the edges, the gift box, power-ups for the
+ * player to gain health, and stairs back up to the secret entrance.
+ */
+static constexpr char SECRET_LAYOUT[] =
+    "WWWWWWWWWWWW"
+    "W          W"
+    "W          W"
+    "W          W"
+    "W          W"
+    "W          W"
+    "W   s      W"
+    "W      G   W"
+    "W          W"
+    "W        + W"
+    "W         mW"
+    "WWWWWWWWWWWW";
+
+static constexpr LayoutPortal SECRET_PORTALS[] = {
+    {4, 6, 0, 48, 48},
+};
+
+static_assert(layout_ok<12, 12>(SECRET_LAYOUT, SECRET_PORTALS), "bad secret map layout");
+static constexpr auto SECRET_MAP = bake_map<12, 12>(SECRET_LAYOUT, SECRET_PORTALS);
+
+
+const MapLayout MAP_LAYOUTS[NUM_MAP_LAYOUTS] = {
+    {&MAIN_MAP,   sizeof(MAIN_MAP),   MAIN_MAP.header.width,   MAIN_MAP.header.height},
+    {&SMALL_MAP,  sizeof(SMALL_MAP),  SMALL_MAP.header.width,  SMALL_MAP.header.height},
+    {&SECRET_MAP, sizeof(SECRET_MAP), SECRET_MAP.header.width, SECRET_MAP.header.height},
+};
@@ -0,0 +1,33 @@
+//=================================================================
+// The built-in map layouts.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#ifndef MAP_LAYOUTS_H
+#define MAP_LAYOUTS_H
+
+/**
+ * The number of built-in maps: the main map, the small map (Buzz's lair)
+ * and the secret map.
+ */
+#define NUM_MAP_LAYOUTS 3
+
+/**
+ * A built-in map, baked at compile time into a map file image in flash (see
+ * map_bake.h). Map m is started with
+ *     map_attach(m, MAP_LAYOUTS[m].image, MAP_LAYOUTS[m].size);
+ */
+typedef struct {
+    const void* image;
+    unsigned int size;
+    int width, height;        // the size of the map, in tiles
+} MapLayout;
+
+extern const MapLayout MAP_LAYOUTS[NUM_MAP_LAYOUTS];
+
+#endif // MAP_LAYOUTS_H
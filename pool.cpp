@@ -0,0 +1,127 @@
+// ============================================
+// The Pool (slab allocator) class file
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#include "pool.h"
+#include "align.h"
+
+#include <stdlib.h> // For malloc and free
+
+/**
+ * The header at the start of every slab. The objects follow it directly.
+ */
+typedef struct _PoolSlab
+{
+    struct _PoolSlab *next;
+} PoolSlab;
+
+/**
+ * A free object is reused to hold the link to the next free object, which is
+ * why objects are never smaller than a pointer.
+ */
+typedef struct _PoolFree
+{
+    struct _PoolFree *next;
+} PoolFree;
+
+struct _Pool
+{
+    /** The padded size of each object */
+    unsigned int object_size;
+
+    /** The number of objects per slab */
+    unsigned int per_slab;
+
+    /** All slabs allocated so far, newest first */
+    PoolSlab *slabs;
+
+    /** The free list of objects ready to hand out */
+    PoolFree *free_list;
+
+    /** Usage counters */
+    PoolStats stats;
+};
+
+/**
+ * addSlab
+ *
+ * Allocates one slab and pushes all of its objects onto the free list.
+ *
+ * @param pool The pointer to the pool.
+ */
+static void addSlab(Pool *pool)
+{
+    unsigned int header = ALIGN_ROUND(sizeof(PoolSlab));
+    PoolSlab *slab = (PoolSlab *)malloc(header + pool->per_slab * pool->object_size);
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    // thread the objects onto the free list back to front, so that they are
+    // handed out in address order
+    char *first = (char *)slab + header;
+    for (unsigned int i = pool->per_slab; i > 0; --i) {
+        PoolFree *object = (PoolFree *)(first + (i - 1) * pool->object_size);
+        object->next = pool->free_list;
+        pool->free_list = object;
+    }
+    pool->stats.capacity += pool->per_slab;
+    pool->stats.slabs++;
+}
+
+Pool *createPool(unsigned int objectSize, unsigned int objectsPerSlab)
+{
+    Pool *pool = (Pool *)malloc(sizeof(Pool));
+    if (objectSize < sizeof(PoolFree)) objectSize = sizeof(PoolFree);
+    pool->object_size = ALIGN_ROUND(objectSize);
+    pool->per_slab = objectsPerSlab ? objectsPerSlab : 1;
+    pool->slabs = NULL;
+    pool->free_list = NULL;
+    pool->stats.in_use = 0;
+    pool->stats.peak = 0;
+    pool->stats.capacity = 0;
+    pool->stats.slabs = 0;
+    return pool;
+}
+
+void destroyPool(Pool *pool)
+{
+    // the objects live inside the slabs, so freeing the slabs frees them all
+    PoolSlab *slab = pool->slabs;
+    while (slab) {
+        PoolSlab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    free(pool);
+}
+
+void *poolAlloc(Pool *pool)
+{
+    if (!pool->free_list) addSlab(pool);
+    PoolFree *object = pool->free_list;
+    pool->free_list = object->next;
+    if (++pool->stats.in_use > pool->stats.peak) {
+        pool->stats.peak = pool->stats.in_use;
+    }
+    return object;
+}
+
+void poolFree(Pool *pool, void *object)
+{
+    if (!object) return;
+    PoolFree *freed = (PoolFree *)object;
+    freed->next = pool->free_list;
+    pool->free_list = freed;
+    pool->stats.in_use--;
+}
+
+void getPoolStats(Pool *pool, PoolStats *stats)
+{
+    *stats = pool->stats;
+}
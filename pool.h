@@ -0,0 +1,94 @@
+// ============================================
+// The header file for the Pool (slab allocator) class file.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+#ifndef POOL_H
+#define POOL_H
+
+/**
+ * A Pool hands out fixed-size objects carved from larger slabs. Allocating
+ * and freeing an object is O(1) (a free-list pop or push), and the heap only
+ * sees one malloc per slab instead of one per object, which keeps the mbed
+ * heap from fragmenting. Destroying the pool releases every slab at once.
+ *
+ * The definition of _Pool is implemented in pool.cpp.
+ */
+typedef struct _Pool Pool;
+
+/**
+ * Usage counters for a pool, filled in by getPoolStats.
+ */
+typedef struct {
+    /** The number of objects currently allocated */
+    unsigned int in_use;
+
+    /** The highest value in_use has reached */
+    unsigned int peak;
+
+    /** The number of objects the allocated slabs can hold */
+    unsigned int capacity;
+
+    /** The number of slabs allocated from the heap */
+    unsigned int slabs;
+} PoolStats;
+
+/**
+ * createPool
+ *
+ * Creates an empty pool. No slab is allocated until the first poolAlloc.
+ *
+ * @param objectSize The size in bytes of every object handed out.
+ * @param objectsPerSlab The number of objects carved from each slab.
+ * @return a pointer to the new pool
+ */
+Pool* createPool(unsigned int objectSize, unsigned int objectsPerSlab);
+
+/**
+ * destroyPool
+ *
+ * Frees every slab and the pool itself. Objects still allocated from the pool
+ * become invalid; they must not be passed to poolFree or used afterwards.
+ *
+ * @param pool The pointer to the pool.
+ */
+void destroyPool(Pool* pool);
+
+/**
+ * poolAlloc
+ *
+ * Allocates one object, adding a new slab if the pool is full. The contents
+ * of the object are uninitialized.
+ *
+ * @param pool The pointer to the pool.
+ * @return a pointer to the object
+ */
+void* poolAlloc(Pool* pool);
+
+/**
+ * poolFree
+ *
+ * Returns an object to the pool. The slab memory is kept for later
+ * allocations. Passing NULL does nothing.
+ *
+ * @param pool The pointer to the pool the object was allocated from.
+ * @param object The object to free.
+ */
+void poolFree(Pool* pool, void* object);
+
+/**
+ * getPoolStats
+ *
+ * Reads the usage counters of a pool.
+ *
+ * @param pool The pointer to the pool.
+ * @param stats The counters are written here.
+ */
+void getPoolStats(Pool* pool, PoolStats* stats);
+
+#endif // POOL_H
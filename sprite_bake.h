@@ -0,0 +1,196 @@
+// ============================================
+// Compile-time conversion of sprites to RGB565 pixels.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+/****************************************************************************
+ * bake_sprite(art)
+ *
+ * Turns the picture of an 11x11 tile into palette indices, while the program
+ * is being compiled. Every sprite shares the colors of SPRITE_PALETTE, and
+ * stores one index per pixel: 4 bits (61 bytes a tile) when all its colors
+ * are among the first 16 entries, 8 bits (121 bytes) otherwise. The result
+ * is a constexpr Sprite, so it is placed in flash; draw_img (see graphics.h)
+ * turns the indices into RGB565 pixels with a table lookup per byte.
+ *
+ * A picture is either a string of 121 characters, one per pixel in row-major
+ * order, written one row per line:
+ *
+ *      'R' red             'Y' yellow          'G' green
+ *      'D' brown ("dirt")  '5' light grey      '3' dark grey
+ *      'B' blue            'P' purple          '4' dark green
+ *      'L' light green     'W' white           anything else is black
+ *
+ * or an array of 121 0xAARRGGBB colors, as Piskel exports them (the alpha
+ * byte is ignored). Pixels past the end of a short string are black, and
+ * characters past the 121st are ignored. A picture string always makes a 4
+ * bit sprite; for a color array, pick the width, and the compiler will
+ * complain if a color isn't in the palette (or, for 4 bits, isn't in its
+ * first 16 entries):
+ *
+ *     static constexpr char art[] =
+ *         "           "
+ *         ...
+ *         "  D  D  D  ";
+ *     static constexpr Sprite<4> sprite = bake_sprite(art);
+ *     draw_img(u, v, sprite);
+ *
+ *     static constexpr Sprite<8> sprite = bake_sprite<8>(piskel_colors);
+ *
+ * This needs a C++11 compiler.
+ ***************************************************************************/
+#ifndef SPRITE_BAKE_H
+#define SPRITE_BAKE_H
+
+#include <stdint.h>
+#include "uLCD_4DGL.h" // for the basic color names
+#include "indices.h"
+
+// additional color definitions
+#define YELLOW 0xFFFF00
+#define BROWN  0xD2691E
+#define DIRT   BROWN
+#define PURPLE 0xA020F0
+#define DGREEN 0x009E60
+#define LGREEN 0xAFE1AF
+// You can define more hex colors here
+
+/** The width and height of a sprite, in pixels */
+#define SPRITE_SIZE   11
+#define SPRITE_PIXELS (SPRITE_SIZE * SPRITE_SIZE)
+
+/**
+ * The colors every sprite is drawn with, as 0xRRGGBB. The first 16 are the
+ * ones a 4 bit sprite can use, starting with the picture characters in the
+ * order sprite_index gives them; a color only an 8 bit sprite needs goes
+ * after those. You can add colors at the end.
+ */
+constexpr uint32_t SPRITE_PALETTE[] = {
+    BLACK, RED, YELLOW, GREEN, DIRT, LGREY, DGREY, BLUE,
+    PURPLE, DGREEN, LGREEN, WHITE,
+    0xFFCCCB,                               // slain Buzz
+    0x0101C4, 0x7C7CFF,                     // water
+    0x00659E,                               // earth
+    // 8 bit sprites only
+    0x137BFF, 0x58110C, 0x606060,           // Buzz
+    0xFF0009, 0xDEB200, 0xDE4600, 0xB30007, // fire
+};
+#define SPRITE_PALETTE_SIZE (sizeof(SPRITE_PALETTE) / sizeof(SPRITE_PALETTE[0]))
+
+/**
+ * An 11x11 tile, as palette indices in row-major order, BITS (4 or 8) bits
+ * each. With 4 bits, each byte holds two pixels, the first one in its low
+ * half.
+ */
+template <int BITS>
+struct Sprite {
+    uint8_t data[(SPRITE_PIXELS * BITS + 7) / 8];
+};
+
+/**
+ * Returns a 0xRRGGBB color in the uLCD's RGB565 format, keeping the top 5,
+ * 6 and 5 bits of red, green and blue, exactly as uLCD.BLIT does.
+ */
+constexpr uint16_t rgb565(uint32_t rgb)
+{
+    return (uint16_t)((((rgb >> 19) & 0x1F) << 11) | (((rgb >> 10) & 0x3F) << 5)
+                      | ((rgb >> 3) & 0x1F));
+}
+
+/**
+ * Returns the palette index of a picture character.
+ */
+constexpr uint8_t sprite_index(char c)
+{
+    // you can add more characters by adding their colors to SPRITE_PALETTE
+    return c == 'R' ? 1
+         : c == 'Y' ? 2
+         : c == 'G' ? 3
+         : c == 'D' ? 4
+         : c == '5' ? 5
+         : c == '3' ? 6
+         : c == 'B' ? 7
+         : c == 'P' ? 8
+         : c == '4' ? 9
+         : c == 'L' ? 10
+         : c == 'W' ? 11
+         : 0;
+}
+
+namespace sprite_bake {
+
+/** the palette index of a 0xRRGGBB color; a compile error if there is none */
+constexpr uint8_t palette_index(uint32_t rgb, unsigned i = 0)
+{
+    return i == SPRITE_PALETTE_SIZE ? throw "color is not in SPRITE_PALETTE"
+         : SPRITE_PALETTE[i] == rgb ? (uint8_t)i
+         : palette_index(rgb, i + 1);
+}
+
+/** index, checked to fit in BITS bits; a compile error if it doesn't */
+template <int BITS>
+constexpr uint8_t fit(uint8_t index)
+{
+    return index < (1 << BITS) ? index : throw "color is past the first 16 in SPRITE_PALETTE";
+}
+
+template <int N>
+constexpr uint8_t art_index(const char (&art)[N], unsigned i)
+{
+    // the last character of art is its terminating zero
+    return (i < N - 1 && i < SPRITE_PIXELS) ? sprite_index(art[i]) : 0;
+}
+
+constexpr uint8_t color_index(const uint32_t (&colors)[SPRITE_PIXELS], unsigned i)
+{
+    return i < SPRITE_PIXELS ? palette_index(colors[i] & 0xFFFFFF) : 0;
+}
+
+template <int N, unsigned... I>
+constexpr Sprite<4> from_art(const char (&art)[N], Indices<I...>)
+{
+    return Sprite<4>{{(uint8_t)(art_index(art, 2 * I) | (art_index(art, 2 * I + 1) << 4))...}};
+}
+
+template <unsigned... I>
+constexpr Sprite<4> from_colors(const uint32_t (&colors)[SPRITE_PIXELS], Indices<I...>,
+                                Sprite<4>*)
+{
+    return Sprite<4>{{(uint8_t)(fit<4>(color_index(colors, 2 * I))
+                                | (fit<4>(color_index(colors, 2 * I + 1)) << 4))...}};
+}
+
+template <unsigned... I>
+constexpr Sprite<8> from_colors(const uint32_t (&colors)[SPRITE_PIXELS], Indices<I...>,
+                                Sprite<8>*)
+{
+    return Sprite<8>{{color_index(colors, I)...}};
+}
+
+} // namespace sprite_bake
+
+/**
+ * Bakes a picture string into a 4 bit Sprite.
+ */
+template <int N>
+constexpr Sprite<4> bake_sprite(const char (&art)[N])
+{
+    return sprite_bake::from_art(art, MakeIndices<sizeof(Sprite<4>::data)>::type());
+}
+
+/**
+ * Bakes an array of Piskel colors into a Sprite of BITS (4 or 8) bits.
+ */
+template <int BITS>
+constexpr Sprite<BITS> bake_sprite(const uint32_t (&colors)[SPRITE_PIXELS])
+{
+    typedef typename MakeIndices<sizeof(Sprite<BITS>::data)>::type Bytes;
+    return sprite_bake::from_colors(colors, Bytes(), (Sprite<BITS>*)0);
+}
+
+#endif // SPRITE_BAKE_H
@@ -0,0 +1,180 @@
+// ============================================
+// Host benchmark for the hash function library.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+/****************************************************************************
+ * hash_bench
+ *
+ * Stores every item location of the built-in maps (MAP_LAYOUTS, in
+ * map_layouts.cpp) in a hash table once per hash function in
+ * hash_functions.h, and reports how evenly the keys are spread and how fast
+ * every cell of the map can be looked up.
+ *
+ * This runs on the host, not the mbed. From the repository root:
+ *
+ *     g++ -std=gnu++11 -O2 -DHT_STATS -I. tools/hash_bench.cpp hash_table.cpp \
+ *         hash_functions.cpp pool.cpp map_layouts.cpp -o hash_bench
+ *     ./hash_bench
+ *
+ * Every non-empty tile of a layout's baked image is an item, portals
+ * included. Keys are x + y * width, as in map.cpp, except for hash_morton,
+ * which is given keys packed as (y << 16) | x.
+ *
+ * Columns:
+ *   mean / max dist  probe distance of the stored items (Robin Hood), or
+ *                    chain length of the non-empty buckets (chained)
+ *   probes/lookup    keys compared per lookup, over every cell of the map
+ *   Mlookups/s       lookups of every cell of the map, repeated
+ ***************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "hash_table.h"
+#include "hash_functions.h"
+#include "map_layouts.h"
+#include "map_format.h"
+
+/** The largest layout that can be loaded */
+#define MAX_SIDE 256
+
+/** The initial number of buckets, as MHF_NBUCKETS in map.cpp */
+#define NUM_BUCKETS 97
+
+/** The number of lookups timed per table */
+#define TIMED_LOOKUPS 4000000
+
+/** The number of histogram bins read back for the distance statistics */
+#define BINS 64
+
+struct Layout {
+    const char* name;
+    int w, h;
+    int num_items;
+    int xs[MAX_SIDE * MAX_SIDE];
+    int ys[MAX_SIDE * MAX_SIDE];
+};
+
+struct NamedHash {
+    const char* name;
+    HashFunction hash;
+    int packed;     // keys are (y << 16) | x instead of x + y * w
+};
+
+static const NamedHash HASHES[] = {
+    {"identity",  hash_identity,  0},
+    {"fibonacci", hash_fibonacci, 0},
+    {"xorshift",  hash_xorshift,  0},
+    {"morton",    hash_morton,    1},
+};
+#define NUM_HASHES ((int)(sizeof(HASHES) / sizeof(HASHES[0])))
+
+static Layout layout;
+
+/** The names of the built-in maps, in MAP_LAYOUTS order */
+static const char* const LAYOUT_NAMES[NUM_MAP_LAYOUTS] = {"main", "small", "secret"};
+
+/**
+ * Reads the item locations of built-in map m into layout. Returns 0 if its
+ * image is too big for layout.
+ */
+static int load_layout(int m)
+{
+    const unsigned char* image = (const unsigned char*)MAP_LAYOUTS[m].image;
+    MapFileHeader header;
+    memcpy(&header, image, sizeof(header));
+    if (header.width > MAX_SIDE || header.height > MAX_SIDE) return 0;
+    const unsigned char* tiles = image + header.tiles_offset;
+    layout.name = LAYOUT_NAMES[m];
+    layout.w = header.width;
+    layout.h = header.height;
+    layout.num_items = 0;
+    for (int y = 0; y < layout.h; y++) {
+        for (int x = 0; x < layout.w; x++) {
+            if (tiles[x + y * layout.w] == MAP_FILE_EMPTY) continue;
+            layout.xs[layout.num_items] = x;
+            layout.ys[layout.num_items] = y;
+            layout.num_items++;
+        }
+    }
+    return 1;
+}
+
+static unsigned int make_key(const NamedHash* h, int x, int y)
+{
+    return h->packed ? ((unsigned)y << 16) | (unsigned)x : (unsigned)(x + y * layout.w);
+}
+
+/**
+ * Builds one table and prints one row of results.
+ */
+static void bench(const NamedHash* h, int backend)
+{
+    static int dummy;
+    HashTable* table = createHashTable(h->hash, NUM_BUCKETS, backend);
+    setHashTableValueFree(table, NULL);
+    for (int i = 0; i < layout.num_items; i++) {
+        insertItem(table, make_key(h, layout.xs[i], layout.ys[i]), &dummy);
+    }
+
+    // distance statistics; chained tables also count their empty buckets,
+    // which are left out of the mean
+    unsigned int bins[BINS];
+    unsigned int longest = getHashTableHistogram(table, bins, BINS);
+    double sum = 0, count = 0;
+    for (int i = (backend == HT_CHAINED); i < BINS; i++) {
+        sum += (double)i * bins[i];
+        count += bins[i];
+    }
+
+    // look up every cell of the map, hits and misses alike
+    resetHashTableStats(table);
+    int cells = layout.w * layout.h;
+    int rounds = TIMED_LOOKUPS / cells + 1;
+    volatile void* sink;
+    clock_t start = clock();
+    for (int r = 0; r < rounds; r++) {
+        for (int y = 0; y < layout.h; y++) {
+            for (int x = 0; x < layout.w; x++) {
+                sink = getItem(table, make_key(h, x, y));
+            }
+        }
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    (void)sink;
+
+    HashTableStats stats;
+    getHashTableStats(table, &stats);
+    printf("  %-10s %-8s %5u %6.2f %6.2f %5u %9.2f %10.1f\n", h->name,
+           backend == HT_ROBIN_HOOD ? "robin" : "chained",
+           getHashTableNumBuckets(table), getHashTableLoadFactor(table),
+           count ? sum / count : 0.0, longest,
+           stats.lookups ? (double)stats.probes / stats.lookups : 0.0,
+           seconds > 0 ? (double)rounds * cells / seconds / 1e6 : 0.0);
+    destroyHashTable(table);
+}
+
+int main()
+{
+#ifndef HT_STATS
+    printf("(built without HT_STATS: probes/lookup reads 0)\n");
+#endif
+    for (int m = 0; m < NUM_MAP_LAYOUTS; m++) {
+        if (!load_layout(m)) {
+            fprintf(stderr, "map %d is larger than %dx%d\n", m, MAX_SIDE, MAX_SIDE);
+            return 1;
+        }
+        printf("%s: %dx%d, %d items\n", layout.name, layout.w, layout.h, layout.num_items);
+        printf("  %-10s %-8s %5s %6s %6s %5s %9s %10s\n", "hash", "backend", "size",
+               "load", "mean", "max", "probes/lk", "Mlookups/s");
+        for (int i = 0; i < NUM_HASHES; i++) bench(&HASHES[i], HT_ROBIN_HOOD);
+        for (int i = 0; i < NUM_HASHES; i++) bench(&HASHES[i], HT_CHAINED);
+        printf("\n");
+    }
+    return 0;
+}
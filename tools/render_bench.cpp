@@ -0,0 +1,123 @@
+// ============================================
+// Host benchmark for the game's drawing code.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+/****************************************************************************
+ * render_bench
+ *
+ * Draws the game's screens with the real graphics, framebuffer and speech
+ * code against the headless uLCD in host/, and reports what each one would
+ * have sent to the display. Each screen is also saved as a PPM picture, so
+ * a change to the drawing code can be checked by eye or by diffing frames.
+ *
+ * This runs on the host, not the mbed. From the repository root:
+ *
+ *     g++ -std=gnu++11 -O2 -Ihost -I. tools/render_bench.cpp graphics.cpp \
+ *         framebuffer.cpp speech.cpp hardware.cpp wave_player.cpp \
+ *         host/uLCD_4DGL.cpp host/mbed.cpp -o render_bench
+ *     ./render_bench [directory for the .ppm files]
+ *
+ * Columns:
+ *   commands     serial commands sent to the display
+ *   bytes        bytes those commands take
+ *   wire ms      time the bytes take at the baudrate hardware_init sets
+ *   wait ms      time spent in wait, wait_ms and wait_us on top of that
+ ***************************************************************************/
+#include <stdio.h>
+#include "globals.h"
+#include "hardware.h"
+#include "graphics.h"
+#include "framebuffer.h"
+#include "speech.h"
+
+// the layout of the map view, as in draw_game
+#define VIEW_WIDTH  11
+#define VIEW_HEIGHT 9
+#define VIEW_U 3
+#define VIEW_V 15
+
+typedef void (*DrawTile)(int u, int v);
+
+/**
+ * Every kind of tile, in the order they fill the view.
+ */
+static const DrawTile tiles[] = {
+    draw_wall, draw_plant, draw_mud, draw_door, draw_npc, draw_stairs,
+    draw_cave1, draw_cave2, draw_cave3, draw_cave4, draw_water, draw_fire,
+    draw_earth, draw_buzz, draw_wreck, draw_slain_buzz, draw_pebble,
+    draw_power_up, draw_gift_box, draw_bush, draw_hole, draw_new_door,
+};
+#define NUM_TILES (sizeof(tiles) / sizeof(tiles[0]))
+
+static void draw_start_screen() { uLCD.cls(); fb_clear(); draw_start_up(); }
+static void draw_config_screen() { uLCD.cls(); fb_clear(); draw_config(); }
+
+/**
+ * A full frame of the map view: the tiles repeated over the view, with the
+ * player in the middle, the border and the status bars.
+ */
+static void draw_tile_view()
+{
+    draw_border();
+    for (int j = 0; j < VIEW_HEIGHT; j++) {
+        for (int i = 0; i < VIEW_WIDTH; i++) {
+            int u = i*11 + VIEW_U;
+            int v = j*11 + VIEW_V;
+            if (i == VIEW_WIDTH/2 && j == VIEW_HEIGHT/2) {
+                draw_nothing(u, v);
+                draw_player(u, v, 1, false);
+            } else {
+                tiles[(i + j*VIEW_WIDTH) % NUM_TILES](u, v);
+            }
+        }
+    }
+    draw_upper_status(5, 4, true);
+    draw_lower_status(40);
+    fb_flush();
+}
+
+static void draw_first_frame() { uLCD.cls(); fb_clear(); draw_tile_view(); }
+static void draw_same_frame() { draw_tile_view(); }
+static void draw_speech() { speech("Hello, traveller!", "Bring me the key."); }
+
+struct Screen {
+    const char* name;
+    void (*draw)();
+};
+
+static const Screen screens[] = {
+    {"start_up", draw_start_screen},
+    {"config",   draw_config_screen},
+    {"view",     draw_first_frame},
+    {"redraw",   draw_same_frame},
+    {"speech",   draw_speech},
+};
+
+int main(int argc, char** argv)
+{
+    const char* dir = argc > 1 ? argv[1] : ".";
+    hardware_init();
+
+    printf("%-10s %10s %10s %10s %10s\n", "screen", "commands", "bytes", "wire ms", "wait ms");
+    for (unsigned s = 0; s < sizeof(screens) / sizeof(screens[0]); s++) {
+        uLCD.reset_stats();
+        unsigned long long waited = host_waited_us();
+        screens[s].draw();
+        printf("%-10s %10lu %10lu %10.2f %10.2f\n", screens[s].name, uLCD.commands(),
+               uLCD.bytes(), uLCD.seconds() * 1000, (host_waited_us() - waited) / 1000.0);
+
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%s.ppm", dir, screens[s].name);
+        if (!uLCD.save_ppm(path)) {
+            printf("can't write %s\n", path);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,527 @@
+// ============================================
+// The header-only TypedHashTable class template.
+//
+// Copyright 2023 Georgia Tech. All rights reserved.
+// The materials provided by the instructor in this course are for
+// the use of the students currently enrolled in the course.
+// Copyrighted course materials may not be further disseminated.
+// This file must NOT be made publicly available anywhere.
+//==================================================================
+
+/****************************************************************************
+ * TypedHashTable<K, V, Hash>
+ *
+ * A Robin Hood open-addressing hash table whose key type, value type and hash
+ * function are compile-time parameters. Because Hash is a functor type rather
+ * than a function pointer, the compiler can inline it into every probe, and
+ * because the slot count is always a power of two, the reduction to a slot
+ * index is a mask instead of a division. Values are stored by value in the
+ * table, so a table of MapItem* or of small structs needs no separate
+ * allocation per entry.
+ *
+ * Hash must be a copyable type with
+ *     unsigned int operator()(const K& key) const;
+ * Only the low bits of the hash are used, so it should mix well.
+ *
+ * Example, a table keyed by a packed (x, y) location:
+ *
+ *     struct XYHash {
+ *         unsigned int operator()(unsigned int xy) const { return xy * 2654435769u >> 7; }
+ *     };
+ *     TypedHashTable<unsigned int, MapItem*, XYHash> tiles(256);
+ *     tiles.insert((y << 16) | x, item);
+ *     MapItem** found = tiles.get((y << 16) | x);
+ *
+ * The C interface in hash_table.h uses this template for its HT_ROBIN_HOOD
+ * backend. Resizing, batched lookups, iteration and the HT_STATS counters
+ * behave as documented there.
+ ***************************************************************************/
+#ifndef TYPED_HASH_TABLE_H
+#define TYPED_HASH_TABLE_H
+
+#include <stdlib.h> // For NULL
+
+/**
+ * Software prefetch hint. Only host builds have a data cache worth warming;
+ * on the Cortex-M target this compiles away.
+ */
+#if defined(__GNUC__) && !defined(__arm__)
+#define THT_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define THT_PREFETCH(addr) ((void)0)
+#endif
+
+/**
+ * Lookup counters are only kept when HT_STATS is defined (see hash_table.h).
+ */
+#ifdef HT_STATS
+#define THT_COUNT(field, n) (stats_.field += (n))
+#else
+#define THT_COUNT(field, n) ((void)0)
+#endif
+
+template <typename K, typename V, typename Hash>
+class TypedHashTable
+{
+public:
+    /**
+     * The position of an iteration over the table. Initialize it with begin.
+     */
+    struct Cursor {
+        unsigned int index;
+        int old;
+    };
+
+    /**
+     * The lookup counters, kept when HT_STATS is defined. A probe is one
+     * stored key compared against the key being looked up.
+     */
+    struct Stats {
+        unsigned int lookups;
+        unsigned int hits;
+        unsigned int misses;
+        unsigned int probes;
+    };
+
+    /**
+     * Creates an empty table with at least numSlots slots (rounded up to a
+     * power of two). The table never shrinks below this size.
+     */
+    explicit TypedHashTable(unsigned int numSlots, Hash hash = Hash())
+        : hash_(hash), size_(0), migrate_pos_(0), stats_()
+    {
+        unsigned int n = 2;
+        while (n < numSlots) n <<= 1;
+        min_slots_ = n;
+        allocate(cur_, n);
+        clear(old_);
+    }
+
+    ~TypedHashTable()
+    {
+        release(cur_);
+        release(old_);
+    }
+
+    /**
+     * Returns a pointer to the value stored for key, or NULL if the key is
+     * not present. The pointer is valid until the table is next modified.
+     */
+    V* get(const K& key)
+    {
+        Slots* where;
+        int slot = lookup(key, &where);
+        return (slot >= 0) ? &where->values[slot] : NULL;
+    }
+
+    /**
+     * Stores value for key. If the key was already present its value is
+     * overwritten, the previous value is copied to *oldValue (if given) and
+     * true is returned; otherwise false is returned.
+     */
+    bool insert(const K& key, const V& value, V* oldValue = NULL)
+    {
+        V* existing = get(key);
+        if (existing) {
+            if (oldValue) *oldValue = *existing;
+            *existing = value;
+            return true;
+        }
+        maintain();
+        place(cur_, key, value);
+        size_++;
+        return false;
+    }
+
+    /**
+     * Removes key from the table using backward-shift deletion. The removed
+     * value is copied to *value (if given). Returns false if the key was not
+     * present.
+     */
+    bool remove(const K& key, V* value = NULL)
+    {
+        Slots* where;
+        int slot = lookup(key, &where);
+        if (slot < 0) return false;
+        if (value) *value = where->values[slot];
+        erase(*where, (unsigned int)slot);
+        size_--;
+        maintain();
+        return true;
+    }
+
+    /**
+     * Looks up n keys at once. values[i] is set to the same pointer get(keys[i])
+     * would return. Keys are resolved a group at a time with their probes
+     * interleaved, so the memory accesses of different keys overlap.
+     */
+    void getMany(const K* keys, V** values, unsigned int n)
+    {
+        for (unsigned int base = 0; base < n; base += BATCH) {
+            unsigned int m = (n - base < (unsigned int)BATCH) ? n - base : (unsigned int)BATCH;
+            getBatch(cur_, keys + base, values + base, m);
+            // mid-resize, keys not found yet may still be in the old storage
+            if (!resizing()) continue;
+            for (unsigned int i = 0; i < m; ++i) {
+                if (values[base + i]) continue;
+                int slot = find(old_, keys[base + i]);
+                if (slot >= 0) values[base + i] = &old_.values[slot];
+            }
+        }
+#ifdef HT_STATS
+        for (unsigned int i = 0; i < n; ++i) {
+            if (values[i]) THT_COUNT(hits, 1);
+            else THT_COUNT(misses, 1);
+        }
+        THT_COUNT(lookups, n);
+#endif
+    }
+
+    /**
+     * Positions a cursor before the first entry.
+     */
+    void begin(Cursor& cursor) const
+    {
+        cursor.index = 0;
+        cursor.old = 0;
+    }
+
+    /**
+     * Advances the cursor to the next entry in slot order, copying out its key
+     * and value (either may be NULL). Returns false once every entry has been
+     * visited. The table must not be modified during an iteration.
+     */
+    bool next(Cursor& cursor, K* key, V* value) const
+    {
+        for (; cursor.old < 2; cursor.old++, cursor.index = 0) {
+            const Slots& s = cursor.old ? old_ : cur_;
+            while (cursor.index < s.num) {
+                unsigned int i = cursor.index++;
+                if (s.dist[i]) {
+                    if (key) *key = s.keys[i];
+                    if (value) *value = s.values[i];
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Calls visit(key, value) for every entry.
+     */
+    template <typename F>
+    void forEach(F visit) const
+    {
+        Cursor cursor;
+        K key;
+        V value;
+        begin(cursor);
+        while (next(cursor, &key, &value)) visit(key, value);
+    }
+
+    /** The number of entries stored */
+    unsigned int size() const { return size_; }
+
+    /** The current number of slots */
+    unsigned int numSlots() const { return cur_.num; }
+
+    /** The number of entries divided by the number of slots */
+    float loadFactor() const { return (float)size_ / (float)cur_.num; }
+
+    /** The lookup counters since construction or the last resetStats */
+    const Stats& stats() const { return stats_; }
+
+    /** Sets every lookup counter back to zero */
+    void resetStats() { stats_ = Stats(); }
+
+    /**
+     * Counts the entries by how many slots past their home slot they sit:
+     * bins[i] gets the entries at distance i, and the last of the numBins
+     * bins also gets everything further. Returns the longest distance.
+     */
+    unsigned int histogram(unsigned int* bins, unsigned int numBins) const
+    {
+        unsigned int longest = 0;
+        for (unsigned int i = 0; i < numBins; ++i) bins[i] = 0;
+        for (int o = 0; o < 2; ++o) {
+            const Slots& s = o ? old_ : cur_;
+            for (unsigned int i = 0; i < s.num; ++i) {
+                if (!s.dist[i]) continue;
+                unsigned int d = s.dist[i] - 1u;
+                if (d > longest) longest = d;
+                bins[d < numBins ? d : numBins - 1]++;
+            }
+        }
+        return longest;
+    }
+
+private:
+    /**
+     * One set of flat arrays. A distance of 0 marks an empty slot; otherwise
+     * it is one more than the number of slots the entry sits past its home.
+     */
+    struct Slots {
+        K* keys;
+        V* values;
+        unsigned short* dist;
+        unsigned int num;
+        unsigned int mask;
+    };
+
+    /** Load factor limits, in percent (see hash_table.h) */
+    enum { MAX_LOAD = 85, MIN_LOAD = 20 };
+
+    /** Non-empty entries migrated, and empty slots skipped, per modification */
+    enum { MIGRATE_STEP = 4, MIGRATE_SCAN = 4 * MIGRATE_STEP };
+
+    /** Keys per interleaved group in getMany */
+    enum { BATCH = 8 };
+
+    /** The largest probe distance that fits in the dist array */
+    enum { MAX_DIST = 65535 };
+
+    Hash hash_;
+    Slots cur_;
+    Slots old_;
+    unsigned int size_;
+    unsigned int min_slots_;
+    unsigned int migrate_pos_;
+    mutable Stats stats_;
+
+    // copying a table is not supported
+    TypedHashTable(const TypedHashTable&);
+    TypedHashTable& operator=(const TypedHashTable&);
+
+    static void clear(Slots& s)
+    {
+        s.keys = NULL;
+        s.values = NULL;
+        s.dist = NULL;
+        s.num = 0;
+        s.mask = 0;
+    }
+
+    static void allocate(Slots& s, unsigned int n)
+    {
+        s.keys = new K[n];
+        s.values = new V[n];
+        // value-initialized, so every slot starts out empty (distance 0)
+        s.dist = new unsigned short[n]();
+        s.num = n;
+        s.mask = n - 1;
+    }
+
+    static void release(Slots& s)
+    {
+        delete[] s.keys;
+        delete[] s.values;
+        delete[] s.dist;
+        clear(s);
+    }
+
+    bool resizing() const { return old_.num != 0; }
+
+    /**
+     * Finds the slot holding key. Entries are kept in Robin Hood order, so the
+     * search stops at the first slot whose entry is closer to its home.
+     */
+    int find(const Slots& s, const K& key) const
+    {
+        if (s.num == 0) return -1;
+        unsigned int slot = hash_(key) & s.mask;
+        unsigned int d = 1;
+        while (s.dist[slot] >= d) {
+            THT_COUNT(probes, 1);
+            if (s.keys[slot] == key) return (int)slot;
+            slot = (slot + 1) & s.mask;
+            d++;
+        }
+        return -1;
+    }
+
+    /**
+     * Finds key in the current slots, then in the old slots mid-resize, and
+     * sets *where to the arrays it was found in. This is one lookup.
+     */
+    int lookup(const K& key, Slots** where)
+    {
+        THT_COUNT(lookups, 1);
+        *where = &cur_;
+        int slot = find(cur_, key);
+        if (slot < 0) {
+            *where = &old_;
+            slot = find(old_, key);
+        }
+        if (slot >= 0) THT_COUNT(hits, 1);
+        else THT_COUNT(misses, 1);
+        return slot;
+    }
+
+    /**
+     * Places a key known not to be in s. Whenever the entry being placed has
+     * probed further than the entry in the current slot, the two are swapped
+     * and the displaced entry continues the probe.
+     */
+    void place(Slots& s, K key, V value)
+    {
+        unsigned int slot = hash_(key) & s.mask;
+        unsigned int d = 1;
+        while (s.dist[slot]) {
+            if (s.dist[slot] < d) {
+                // swap the poorer entry into this slot and carry the richer one on
+                K tk = s.keys[slot];
+                V tv = s.values[slot];
+                unsigned int td = s.dist[slot];
+                s.keys[slot] = key;
+                s.values[slot] = value;
+                s.dist[slot] = (unsigned short)d;
+                key = tk;
+                value = tv;
+                d = td;
+            }
+            slot = (slot + 1) & s.mask;
+            d++;
+            if (d >= MAX_DIST) {
+                // probe distance no longer fits; grow and place the carried entry
+                growNow(s);
+                place(s, key, value);
+                return;
+            }
+        }
+        s.keys[slot] = key;
+        s.values[slot] = value;
+        s.dist[slot] = (unsigned short)d;
+    }
+
+    /**
+     * Doubles s and re-places every entry at once. Normal growth is
+     * incremental; this is only the fallback for a probe distance overflow.
+     */
+    void growNow(Slots& s)
+    {
+        Slots old = s;
+        allocate(s, old.num * 2);
+        for (unsigned int i = 0; i < old.num; ++i) {
+            if (old.dist[i]) place(s, old.keys[i], old.values[i]);
+        }
+        release(old);
+    }
+
+    /**
+     * Empties a slot with backward-shift deletion: every following entry that
+     * is not in its home slot moves back by one, so no tombstones are needed.
+     */
+    static void erase(Slots& s, unsigned int slot)
+    {
+        unsigned int next = (slot + 1) & s.mask;
+        while (s.dist[next] > 1) {
+            s.keys[slot] = s.keys[next];
+            s.values[slot] = s.values[next];
+            s.dist[slot] = s.dist[next] - 1;
+            slot = next;
+            next = (next + 1) & s.mask;
+        }
+        s.dist[slot] = 0;
+    }
+
+    /**
+     * Looks up at most BATCH keys in s, advancing every pending lookup by one
+     * slot per round. Keys that are not found get NULL.
+     */
+    void getBatch(const Slots& s, const K* keys, V** values, unsigned int n)
+    {
+        unsigned int slot[BATCH];
+        unsigned int d[BATCH];
+        bool pending[BATCH];
+        unsigned int left = 0;
+
+        // hash every key up front and start fetching its home slot
+        for (unsigned int i = 0; i < n; ++i) {
+            values[i] = NULL;
+            pending[i] = s.num != 0;
+            if (!pending[i]) continue;
+            slot[i] = hash_(keys[i]) & s.mask;
+            d[i] = 1;
+            left++;
+            THT_PREFETCH(&s.dist[slot[i]]);
+            THT_PREFETCH(&s.keys[slot[i]]);
+        }
+
+        // one probe step per pending key per round
+        while (left) {
+            for (unsigned int i = 0; i < n; ++i) {
+                if (!pending[i]) continue;
+                unsigned int at = slot[i];
+                if (s.dist[at] < d[i]) {
+                    pending[i] = false;
+                    left--;
+                    continue;
+                }
+                THT_COUNT(probes, 1);
+                if (s.keys[at] == keys[i]) {
+                    values[i] = &s.values[at];
+                    pending[i] = false;
+                    left--;
+                } else {
+                    slot[i] = (at + 1) & s.mask;
+                    d[i]++;
+                    THT_PREFETCH(&s.dist[slot[i]]);
+                }
+            }
+        }
+    }
+
+    /**
+     * Moves a bounded number of entries from the old arrays into the current
+     * ones, and frees the old arrays once they are empty. Every old slot
+     * before migrate_pos_ is already empty, because erasing with a backward
+     * shift only ever pulls entries down from later slots.
+     */
+    void migrateStep(unsigned int budget)
+    {
+        unsigned int scanned = 0;
+        while (budget && migrate_pos_ < old_.num && scanned < MIGRATE_SCAN) {
+            if (old_.dist[migrate_pos_]) {
+                K key = old_.keys[migrate_pos_];
+                V value = old_.values[migrate_pos_];
+                erase(old_, migrate_pos_);
+                place(cur_, key, value);
+                budget--;
+            } else {
+                migrate_pos_++;
+                scanned++;
+            }
+        }
+        if (migrate_pos_ >= old_.num) release(old_);
+    }
+
+    /**
+     * Allocates new, empty arrays and keeps the current ones as the old
+     * arrays to migrate from. Any resize still in progress is finished first.
+     */
+    void startResize(unsigned int n)
+    {
+        while (resizing()) migrateStep(old_.num);
+        old_ = cur_;
+        allocate(cur_, n);
+        migrate_pos_ = 0;
+    }
+
+    /**
+     * Called by every modification: advances a resize in progress, and starts
+     * a new one when the load factor has left the allowed range.
+     */
+    void maintain()
+    {
+        if (resizing()) migrateStep(MIGRATE_STEP);
+        unsigned int n = cur_.num;
+        if ((size_ + 1) * 100 > n * MAX_LOAD) {
+            startResize(n * 2);
+        } else if (n > min_slots_ && size_ * 100 < n * MIN_LOAD && !resizing()) {
+            startResize(n / 2);
+        }
+    }
+};
+
+#endif // TYPED_HASH_TABLE_H